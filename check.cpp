@@ -0,0 +1,6 @@
+#include "source code/Check.cpp"
+
+int main() {
+    // "check" runs every check and exits with 1 if one of them failed
+    return Check::run() ? 0 : 1;
+}
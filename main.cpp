@@ -1,7 +1,92 @@
 #include "source code/Game.cpp"
+#include "source code/Bench.cpp"
+#include "source code/Batch.cpp"
+#include <fstream>
+#include <string>
 
-int main() {
+int main(int argc, char *argv[]) {
+    // "main bench [threads] [depth]" measures search speed for 1 to threads threads instead of playing
+    if(argc > 1 && std::string(argv[1]) == "bench") {
+        int threads = argc > 2 ? std::stoi(argv[2]) : int(std::thread::hardware_concurrency());
+        int depth = argc > 3 ? std::stoi(argv[3]) : 11;
+        Bench::run(threads, depth);
+        return 0;
+    }
+
+    // "main uci" speaks the Universal Chess Interface from the start
+    if(argc > 1 && std::string(argv[1]) == "uci") {
+        Uci uci;
+        uci.loop();
+        return 0;
+    }
+
+    // "main batch <file> [depth <n>] [nodes <n>] [threads <n>] [hash <mb>] [evalfile <path>] [syzygy <dirs>]" analyses
+    // every FEN or EPD line of the file, or of stdin for "-", and writes the results as JSON lines. a node budget alone
+    // searches as deep as it allows. evalfile loads a network to eval with, syzygy the endgame tablebases
+    if(argc > 2 && std::string(argv[1]) == "batch") {
+        Batch::Limits limits;
+        limits.threads = int(std::max(std::thread::hardware_concurrency(), 1u));
+        bool depthGiven = false;
+        for(int i = 3; i + 1 < argc; i += 2) {
+            std::string option = argv[i];
+            if(option == "depth") {
+                limits.depth = std::min(std::max(std::stoi(argv[i + 1]), 1), Search::maxSearchDepth);
+                depthGiven = true;
+            } else if(option == "nodes") {
+                limits.nodes = std::stoull(argv[i + 1]);
+            } else if(option == "threads") {
+                limits.threads = std::stoi(argv[i + 1]);
+            } else if(option == "hash") {
+                limits.hashMB = std::max(std::stoi(argv[i + 1]), 1);
+            } else if(option == "evalfile") {
+                try {
+                    Network::load(argv[i + 1]);
+                } catch(const std::runtime_error &e) {
+                    std::cerr << e.what() << "\n";
+                    return 1;
+                }
+            } else if(option == "syzygy") {
+                Tablebase::init(argv[i + 1]);
+            } else {
+                std::cerr << "unknown option " << option << "\n";
+                return 1;
+            }
+        }
+        if(limits.nodes != 0 && !depthGiven) limits.depth = Search::maxSearchDepth;
+
+        std::string path = argv[2];
+        if(path == "-") {
+            Batch::run(std::cin, std::cout, limits);
+            return 0;
+        }
+        std::ifstream file(path);
+        if(!file) {
+            std::cerr << "can't open " << path << "\n";
+            return 1;
+        }
+        Batch::run(file, std::cout, limits);
+        return 0;
+    }
+
+    // "main [book <book.bin>] [syzygy <dirs>]" plays in the terminal, with a Polyglot opening book and Syzygy endgame
+    // tablebases if given
     Game game;
+    for(int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if(option == "book" && i + 1 < argc) {
+            try {
+                game.useBook(argv[++i]);
+            } catch(const std::runtime_error &e) {
+                std::cerr << e.what() << "\n";
+                return 1;
+            }
+        } else if(option == "syzygy" && i + 1 < argc) {
+            Tablebase::init(argv[++i]);
+        } else {
+            std::cerr << "unknown option " << option << "\n";
+            return 1;
+        }
+    }
     game.play();
     return 0;
 }
@@ -0,0 +1,38 @@
+#include "source code/Perft.cpp"
+#include <string>
+
+int main(int argc, char *argv[]) {
+    // "perft" runs the standard suite, "perft <depth> [fen]" counts one position and "perft divide <depth> [fen]"
+    // also prints the count below each root move. the start position is used when no FEN is given
+    if(argc < 2) return Perft::runSuite() ? 0 : 1;
+
+    bool divide = std::string(argv[1]) == "divide";
+    int arg = divide ? 2 : 1;
+    if(argc <= arg) {
+        std::cout << "usage: perft [divide] <depth> [fen]\n";
+        return 1;
+    }
+    int depth = std::stoi(argv[arg++]);
+
+    // the FEN may be passed quoted or as separate arguments
+    std::string fen;
+    for(; arg < argc; arg++) fen += std::string(argv[arg]) + " ";
+    BoardState board;
+    try {
+        if(!fen.empty()) board = BoardState::fromFEN(fen);
+    } catch(const std::invalid_argument &e) {
+        std::cout << e.what() << "\n";
+        return 1;
+    }
+
+    if(divide) {
+        Perft::divide(board, depth);
+    } else {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = Perft::count(board, depth);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "nodes: " << nodes << "\ntime(ms): " << int(seconds * 1000) << "\nnodes/sec: "
+        << uint64_t(nodes / std::max(seconds, 1e-9)) << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include "Bitboard.cpp"
+
+//
+// Attack lookup tables, filled once at startup. Knights, kings and pawns have one attack mask per square. Rooks and
+// bishops use magic bitboards: the pieces on the squares that can block a slider are multiplied by a per square magic
+// number, and the top bits of the product index a table of precomputed attacks for exactly that set of blockers. The
+// magics are searched for from fixed seeds, so they are the same on every run.
+//
+
+class AttackTables {
+public:
+    AttackTables();
+    Bitboard rook(int sq, Bitboard occupied) const;
+    Bitboard bishop(int sq, Bitboard occupied) const;
+    Bitboard queen(int sq, Bitboard occupied) const;
+
+    Bitboard knight [64];
+    Bitboard king [64];
+    Bitboard pawn [2][64]; // squares a white (0) or black (1) pawn on the square attacks
+    Bitboard between [64][64]; // squares strictly between two squares on a line, empty if they aren't on one
+    Bitboard line [64][64]; // the whole line through two squares, edge to edge, empty if they aren't on one
+
+private:
+    struct Magic {
+        Bitboard mask; // squares that can block the slider, board edges left out
+        uint64_t magic;
+        int shift; // 64 minus the number of bits in mask
+        int offset; // start of this square's attacks in the table
+
+        int index(Bitboard occupied) const;
+    };
+
+    Magic rookMagics [64];
+    Magic bishopMagics [64];
+    // sum over all squares of 2 ^ bits in mask
+    Bitboard rookTable [102400];
+    Bitboard bishopTable [5248];
+
+    // generator seeds by rank of the square that find all magics within a few tries
+    constexpr const static uint64_t rankSeeds [8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+    uint64_t seed;
+    uint64_t next();
+    void findMagics(Magic *magics, Bitboard *table, Bitboard (*attacks)(Bitboard, Bitboard));
+};
+
+AttackTables::AttackTables() {
+    for(int sq = 0; sq < 64; sq++) {
+        knight[sq] = knightAttacks(bit(sq));
+        king[sq] = kingAttacks(bit(sq));
+        pawn[0][sq] = pawnAttacks(bit(sq), true);
+        pawn[1][sq] = pawnAttacks(bit(sq), false);
+    }
+
+    findMagics(rookMagics, rookTable, rookAttacks);
+    findMagics(bishopMagics, bishopTable, bishopAttacks);
+
+    for(int a = 0; a < 64; a++) {
+        for(int b = 0; b < 64; b++) {
+            between[a][b] = 0;
+            line[a][b] = 0;
+            if(a == b) continue;
+            if(rook(a, 0) & bit(b)) {
+                between[a][b] = rook(a, bit(b)) & rook(b, bit(a));
+                line[a][b] = (rook(a, 0) & rook(b, 0)) | bit(a) | bit(b);
+            } else if(bishop(a, 0) & bit(b)) {
+                between[a][b] = bishop(a, bit(b)) & bishop(b, bit(a));
+                line[a][b] = (bishop(a, 0) & bishop(b, 0)) | bit(a) | bit(b);
+            }
+        }
+    }
+}
+
+inline int AttackTables::Magic::index(Bitboard occupied) const {
+    return offset + int(((occupied & mask) * magic) >> shift);
+}
+
+// squares a rook on sq attacks, up to and including the first piece in each direction
+inline Bitboard AttackTables::rook(int sq, Bitboard occupied) const {
+    return rookTable[rookMagics[sq].index(occupied)];
+}
+
+inline Bitboard AttackTables::bishop(int sq, Bitboard occupied) const {
+    return bishopTable[bishopMagics[sq].index(occupied)];
+}
+
+inline Bitboard AttackTables::queen(int sq, Bitboard occupied) const {
+    return rook(sq, occupied) | bishop(sq, occupied);
+}
+
+// xorshift64* generator
+uint64_t AttackTables::next() {
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return seed * 0x2545F4914F6CDD1DULL;
+}
+
+// for every square, tries random magics with few bits set until one maps every blocker set to a table entry that
+// holds its attacks. two blocker sets may share an entry only if they give the same attacks. attacks is the slow
+// set wise attack function the table is filled from
+void AttackTables::findMagics(Magic *magics, Bitboard *table, Bitboard (*attacks)(Bitboard, Bitboard)) {
+    Bitboard blockers [4096];
+    Bitboard reference [4096];
+    int epoch [4096] = {}; // attempt that last wrote each table entry, so entries don't have to be cleared per attempt
+    int attempt = 0;
+    int offset = 0;
+
+    for(int sq = 0; sq < 64; sq++) {
+        // a piece on the edge of the board can't block anything behind it, unless the slider is on that edge too
+        Bitboard edges = ((rank1 | rank8) & ~(rank1 << (8 * (sq / 8)))) | ((fileA | fileH) & ~(fileA << (sq % 8)));
+        Magic &m = magics[sq];
+        m.mask = attacks(bit(sq), 0) & ~edges;
+        m.shift = 64 - popCount(m.mask);
+        m.offset = offset;
+        seed = rankSeeds[sq / 8];
+
+        // every subset of the mask, by the carry rippler trick
+        int size = 0;
+        Bitboard b = 0;
+        do {
+            blockers[size] = b;
+            reference[size] = attacks(bit(sq), b);
+            size++;
+            b = (b - m.mask) & m.mask;
+        } while(b);
+
+        for(int i = 0; i < size;) {
+            // sparse candidates are far more likely to work. the top byte of the product must be well mixed
+            m.magic = next() & next() & next();
+            if(popCount((m.magic * m.mask) >> 56) < 6) continue;
+
+            attempt++;
+            for(i = 0; i < size; i++) {
+                int idx = int((blockers[i] * m.magic) >> m.shift);
+                if(epoch[idx] < attempt) {
+                    epoch[idx] = attempt;
+                    table[offset + idx] = reference[i];
+                } else if(table[offset + idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+        offset += size;
+    }
+}
+
+constexpr const uint64_t AttackTables::rankSeeds [8];
+
+const AttackTables attackTables;
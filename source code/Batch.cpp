@@ -0,0 +1,184 @@
+#pragma once
+#include "Search.cpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <sstream>
+
+//
+// Analyses a file of positions without supervision. Reads one FEN or EPD position per line, searches each to a fixed
+// depth or node budget and writes one JSON object per position. Worker threads each run their own single threaded
+// search and take positions from a queue of fixed size, so memory stays the same however long the input is. Results
+// are written as they finish and carry the input line number, so they can come out of order.
+//
+
+class Batch {
+public:
+    struct Limits {
+        int depth = 8;
+        uint64_t nodes = 0; // 0 for no node budget
+        int threads = 1;
+        int hashMB = 16; // per thread
+    };
+
+    static void run(std::istream &in, std::ostream &out, const Limits &limits);
+
+private:
+    // a line read from the input, numbered from 1
+    struct Job {
+        uint64_t line;
+        std::string text;
+    };
+
+    // hands jobs from the reader to the workers. push waits while the queue is full, pop waits while it is empty and
+    // returns false once the reader is done and nothing is left
+    class JobQueue {
+    public:
+        explicit JobQueue(size_t capacity);
+        void push(Job job);
+        bool pop(Job &job);
+        void close();
+
+    private:
+        std::deque<Job> jobs;
+        size_t capacity;
+        bool closed = false;
+        std::mutex lock;
+        std::condition_variable notFull;
+        std::condition_variable notEmpty;
+    };
+
+    static void work(JobQueue &queue, std::ostream &out, std::mutex &outputLock, const Limits &limits);
+    static std::string analyse(const Job &job, Search &search, const Limits &limits);
+    static std::string quote(const std::string &text);
+
+    // queued jobs per worker, enough that no worker waits on the reader
+    const static int jobsPerThread = 4;
+};
+
+// reads positions from in until it ends and writes a result line for each non empty one to out
+void Batch::run(std::istream &in, std::ostream &out, const Limits &limits) {
+    int threads = std::max(limits.threads, 1);
+    JobQueue queue(size_t(threads) * jobsPerThread);
+    std::mutex outputLock;
+
+    std::vector<std::thread> workers;
+    for(int i = 0; i < threads; i++) {
+        workers.emplace_back(&Batch::work, std::ref(queue), std::ref(out), std::ref(outputLock), std::cref(limits));
+    }
+
+    std::string text;
+    for(uint64_t line = 1; std::getline(in, text); line++) {
+        if(text.find_first_not_of(" \t\r") == std::string::npos || text[0] == '#') continue;
+        queue.push({line, text});
+    }
+    queue.close();
+    for(auto &worker : workers) worker.join();
+}
+
+// one worker thread: analyses jobs until the queue is closed and empty
+void Batch::work(JobQueue &queue, std::ostream &out, std::mutex &outputLock, const Limits &limits) {
+    TranspositionTable table(limits.hashMB);
+    Search search(table);
+    search.setNodeLimit(limits.nodes);
+
+    Job job;
+    while(queue.pop(job)) {
+        std::string result = analyse(job, search, limits);
+        std::lock_guard<std::mutex> guard(outputLock);
+        out << result << std::endl;
+    }
+}
+
+// searches the position of one input line and returns its result as a JSON object, or an error object if the line
+// isn't a position. an EPD line has four position fields followed by operations like bm e4; id "name";
+std::string Batch::analyse(const Job &job, Search &search, const Limits &limits) {
+    std::istringstream fields(job.text);
+    std::string fen, field;
+    for(int i = 0; i < 6 && fields >> field; i++) {
+        // the move counters of a FEN are optional, anything else after the fourth field starts the operations
+        if(i >= 4 && field.find_first_not_of("0123456789") != std::string::npos) break;
+        fen += (i > 0 ? " " : "") + field;
+        field.clear();
+    }
+    std::string operations = field + std::string(std::istreambuf_iterator<char>(fields), {});
+
+    std::string json = "{\"line\":" + std::to_string(job.line);
+    // the EPD id operation names the position
+    size_t id = operations.find("id \"");
+    if(id != std::string::npos) {
+        size_t end = operations.find('"', id + 4);
+        json += ",\"id\":" + quote(operations.substr(id + 4, end == std::string::npos ? end : end - id - 4));
+    }
+
+    BoardState board;
+    try {
+        board = BoardState::fromFEN(fen);
+    } catch(const std::invalid_argument &e) {
+        return json + ",\"error\":" + quote(e.what()) + "}";
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Move best = search.bestMove(board, std::chrono::hours(24), limits.depth);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    std::string pv;
+    for(const std::string &move : board.lineStrings(search.principalVariation())) {
+        pv += (pv.empty() ? "" : ",") + quote(move);
+    }
+
+    // mates also give the moves to mate, negative if the side to move gets mated
+    Score score = search.bestScore();
+    std::string mate = isMateScore(score) ? ",\"mate\":" + std::to_string(mateMoves(score)) : "";
+    json += ",\"fen\":" + quote(board.toFEN()) + ",\"bestmove\":"
+            + (best.special() == -1 ? "null" : quote(board.moveString(best))) + ",\"score\":"
+            + std::to_string(score) + mate + ",\"pv\":[" + pv + "],\"depth\":"
+            + std::to_string(search.depthReached()) + ",\"nodes\":" + std::to_string(search.nodeCount())
+            + ",\"time_ms\":" + std::to_string(ms.count()) + "}";
+    return json;
+}
+
+// text as a JSON string, with quotes, backslashes and control characters escaped
+std::string Batch::quote(const std::string &text) {
+    std::string str = "\"";
+    for(char c : text) {
+        if(c == '"' || c == '\\') {
+            str += '\\';
+            str += c;
+        } else if(static_cast<unsigned char>(c) < 0x20) {
+            const char *hex = "0123456789abcdef";
+            str += "\\u00";
+            str += hex[c >> 4];
+            str += hex[c & 15];
+        } else {
+            str += c;
+        }
+    }
+    return str + "\"";
+}
+
+Batch::JobQueue::JobQueue(size_t capacity) : capacity(capacity) {}
+
+void Batch::JobQueue::push(Job job) {
+    std::unique_lock<std::mutex> guard(lock);
+    notFull.wait(guard, [this]() { return jobs.size() < capacity; });
+    jobs.push_back(std::move(job));
+    notEmpty.notify_one();
+}
+
+bool Batch::JobQueue::pop(Job &job) {
+    std::unique_lock<std::mutex> guard(lock);
+    notEmpty.wait(guard, [this]() { return !jobs.empty() || closed; });
+    if(jobs.empty()) return false;
+    job = std::move(jobs.front());
+    jobs.pop_front();
+    notFull.notify_one();
+    return true;
+}
+
+// no more jobs are coming, workers finish what is queued and stop
+void Batch::JobQueue::close() {
+    std::lock_guard<std::mutex> guard(lock);
+    closed = true;
+    notEmpty.notify_all();
+}
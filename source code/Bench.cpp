@@ -0,0 +1,68 @@
+#pragma once
+#include "Search.cpp"
+#include <iomanip>
+
+//
+// Measures how the search scales with threads. Searches a few positions to a fixed depth with 1, 2, ... n threads
+// and prints the total time to depth, nodes per second and the speedup over one thread, with move ordering and pawn
+// table stats.
+//
+// Wall clock speedup needs a core for every thread. The depth speedup column doesn't: it compares the nodes the main
+// thread searched before the depth was reached, which is the time to depth when every thread runs at full speed. On a
+// machine with fewer cores than threads it is the one to read.
+//
+
+class Bench {
+public:
+    static void run(int maxThreads, int depth);
+
+private:
+    const static int hashSizeMB = 64;
+    const static char *const positions [];
+};
+
+// the start position, an open middlegame, a closed middlegame and an endgame
+const char *const Bench::positions [] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+void Bench::run(int maxThreads, int depth) {
+    TranspositionTable table(hashSizeMB);
+    Search search(table);
+    double baseTime = 0;
+    uint64_t baseMainNodes = 0;
+
+    std::cout << std::thread::hardware_concurrency() << " cores, depth " << depth << "\n";
+    std::cout << "threads  time(ms)        nodes   nodes/sec  speedup  depth speedup  first move cutoffs  pawn table"
+                 " hits\n";
+    for(int threads = 1; threads <= maxThreads; threads++) {
+        search.setThreads(threads);
+        double ms = 0;
+        uint64_t nodes = 0, mainNodes = 0;
+        SearchStats stats;
+
+        for(const char *fen : positions) {
+            table.clear();
+            search.clear();
+            BoardState root = BoardState::fromFEN(fen);
+            auto start = std::chrono::steady_clock::now();
+            search.bestMove(root, std::chrono::hours(24), depth);
+            ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            nodes += search.nodeCount();
+            mainNodes += search.mainThreadNodes();
+            stats.add(search.stats());
+        }
+        if(threads == 1) {
+            baseTime = ms;
+            baseMainNodes = mainNodes;
+        }
+
+        std::cout << std::setw(7) << threads << std::setw(10) << int(ms) << std::setw(13) << nodes << std::setw(12)
+        << uint64_t(nodes / (ms / 1000)) << std::setw(9) << std::fixed << std::setprecision(2) << baseTime / ms
+        << std::setw(15) << double(baseMainNodes) / double(mainNodes) << std::setw(19) << std::setprecision(1)
+        << 100 * stats.firstMoveCutoffRate() << "%" << std::setw(16) << 100 * stats.pawnHitRate() << "%\n";
+    }
+}
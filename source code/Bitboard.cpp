@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+
+//
+// Bitboard helpers. A bitboard is a 64 bit mask with one bit per square, where square x + 8 * y maps to bit
+// x + 8 * y (a1 is bit 0, h1 is bit 7, h8 is bit 63). Whole sets of pieces can be moved or tested with shifts and masks.
+//
+
+typedef uint64_t Bitboard;
+
+const Bitboard fileA = 0x0101010101010101ULL;
+const Bitboard fileB = fileA << 1;
+const Bitboard fileG = fileA << 6;
+const Bitboard fileH = fileA << 7;
+const Bitboard rank1 = 0xFFULL;
+const Bitboard rank2 = rank1 << 8;
+const Bitboard rank3 = rank1 << 16;
+const Bitboard rank6 = rank1 << 40;
+const Bitboard rank7 = rank1 << 48;
+const Bitboard rank8 = rank1 << 56;
+const Bitboard centerSquares = 0x00003C3C3C3C0000ULL; // c3 to f6
+
+// square index from coordinates
+inline int square(int x, int y) {
+    return x + 8 * y;
+}
+
+// bitboard with only the given square set
+inline Bitboard bit(int sq) {
+    return 1ULL << sq;
+}
+
+inline int popCount(Bitboard b) {
+    return __builtin_popcountll(b);
+}
+
+// index of the lowest set square, b must not be empty
+inline int lsb(Bitboard b) {
+    return __builtin_ctzll(b);
+}
+
+// removes the lowest set square from b and returns its index
+inline int popLsb(Bitboard &b) {
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+// one step shifts, bits that would wrap around the edge of the board are dropped
+
+inline Bitboard north(Bitboard b) {
+    return b << 8;
+}
+
+inline Bitboard south(Bitboard b) {
+    return b >> 8;
+}
+
+inline Bitboard east(Bitboard b) {
+    return (b & ~fileH) << 1;
+}
+
+inline Bitboard west(Bitboard b) {
+    return (b & ~fileA) >> 1;
+}
+
+inline Bitboard northEast(Bitboard b) {
+    return (b & ~fileH) << 9;
+}
+
+inline Bitboard northWest(Bitboard b) {
+    return (b & ~fileA) << 7;
+}
+
+inline Bitboard southEast(Bitboard b) {
+    return (b & ~fileH) >> 7;
+}
+
+inline Bitboard southWest(Bitboard b) {
+    return (b & ~fileA) >> 9;
+}
+
+// set wise attacks of every square in a bitboard. single pieces look their attacks up in attackTables instead, these
+// fill those tables and handle whole groups of pieces like all pawns of one side
+
+// slides every square in from along one direction until the ray leaves the board or hits a piece. the blocking
+// square is included so captures can be masked in by the caller
+inline Bitboard slide(Bitboard from, Bitboard empty, Bitboard (*step)(Bitboard)) {
+    Bitboard attacks = 0;
+    for(Bitboard ray = step(from); ray; ray = step(ray & empty)) {
+        attacks |= ray;
+    }
+    return attacks;
+}
+
+inline Bitboard rookAttacks(Bitboard from, Bitboard occupied) {
+    Bitboard empty = ~occupied;
+    return slide(from, empty, north) | slide(from, empty, south)
+    | slide(from, empty, east) | slide(from, empty, west);
+}
+
+inline Bitboard bishopAttacks(Bitboard from, Bitboard occupied) {
+    Bitboard empty = ~occupied;
+    return slide(from, empty, northEast) | slide(from, empty, northWest)
+    | slide(from, empty, southEast) | slide(from, empty, southWest);
+}
+
+inline Bitboard knightAttacks(Bitboard b) {
+    Bitboard one = east(b) | west(b);
+    Bitboard two = ((b & ~(fileG | fileH)) << 2) | ((b & ~(fileA | fileB)) >> 2);
+    return (one << 16) | (one >> 16) | (two << 8) | (two >> 8);
+}
+
+inline Bitboard kingAttacks(Bitboard b) {
+    Bitboard attacks = east(b) | west(b);
+    b |= attacks;
+    return attacks | north(b) | south(b);
+}
+
+// squares attacked by pawns of the given color
+inline Bitboard pawnAttacks(Bitboard b, bool white) {
+    return white ? northEast(b) | northWest(b) : southEast(b) | southWest(b);
+}
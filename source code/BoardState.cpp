@@ -1,102 +1,365 @@
+#pragma once
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "cppcoreguidelines-narrowing-conversions"
 #include "Square.cpp"
 #include "Move.cpp"
+#include "Attacks.cpp"
+#include "Zobrist.cpp"
+#include "PolyglotKeys.cpp"
+#include "PawnTable.cpp"
+#include "Nnue.cpp"
+#include "Score.cpp"
+#include <algorithm>
 #include <vector>
-#include <cfloat>
 #include <cmath>
+#include <stdexcept>
+#include <string_view>
 
 //
-// Representation of a board state. Has an array of squares, as well as info on whose turn it is and castling rights.
-// You can initiate a move on a board state to return the new board state.
+// Representation of a board state. Pieces are stored as bitboards, one per piece type and color, plus occupancy
+// masks for each side and a mailbox for looking up the piece on a single square. Also has info on whose turn it is,
+// castling rights and the en passant square, and a Zobrist hash of all of it that is updated with every move.
+// You can initiate a move on a board state to return the new board state, or make and unmake moves in place.
 //
 
+// everything makeMove overwrites that can't be recovered from the move itself
+struct Undo {
+    uint64_t hash;
+    int32_t halfmoveClock;
+    int32_t repetitionPlies;
+    int8_t captured; // id of the taken piece, 0 if none
+    int8_t epSquare;
+    bool canCastle [4];
+    int8_t king [4];
+};
+
 class BoardState {
 public:
     // Engine
     BoardState();
-    BoardState(const BoardState &old);
+    BoardState(const BoardState &old) = default;
+    BoardState &operator = (const BoardState &old) = default;
+    static BoardState fromFEN(std::string_view fen);
+    std::string toFEN() const;
     BoardState movePiece(Move move);
+    Undo makeMove(Move move);
+    void unmakeMove(Move move, Undo undo);
+    Undo makeNullMove();
+    void unmakeNullMove(Undo undo);
     std::string display();
     bool isWhiteTurn() const;
     bool legalMove(Move move);
     Square getSquare(int x, int y);
+    int pieceAt(int sq) const;
+    bool isCapture(Move move) const;
+    int capturedPiece(Move move) const;
     bool inCheck(bool white);
+    int pieceMaterial(bool white) const;
+    int pieceCount() const;
+    Bitboard pieceBoard(bool white, int id) const;
+    bool hasCastlingRights() const;
+    int getHalfmoveClock() const;
+    int getRepetitionPlies() const;
+    bool fiftyMoveDraw();
+    uint64_t getHash() const;
+    uint64_t polyglotKey() const;
     std::string printMoves();
+    std::string moveString(Move move) const;
+    std::vector<std::string> lineStrings(const std::vector<Move> &line) const;
+    Move moveFromString(std::string_view text);
     std::vector< std::pair<int,int> > getChecks(bool white);
     // AI
-    double eval();
-    Move bestMove();
-    double minimax(BoardState current, int depth, double alpha, double beta);
+    Score eval();
+    Score eval(PawnTable &pawnTable);
     bool checkmate();
-    void getMoves();
+    void generateMoves(MoveList &list);
+    void generateCaptures(MoveList &list);
+    void generateQuiets(MoveList &list);
     bool operator () (const Move& move1, const Move& move2);
 
+    constexpr const static int pieceValue [7] = {0, 5, 3, 3, 9, 0, 1}; // indexed by piece id
 
 private:
-    Square squares [8][8];
+    Bitboard pieces [12]{}; // white rook, knight, bishop, queen, king, pawn, then the same for black
+    Bitboard occupied [2]{}; // all white pieces, all black pieces
+    int mailbox [64]{}; // piece id on each square, 0 if empty. color is found in occupied
+    int epSquare; // square a pawn can capture onto en passant, -1 if none
     bool whiteTurn; // true for white, false for black
     bool canCastle [4]{}; // white short castle, white long castle, black short castle, black long castle
     int king [4]{}; // white king x, white king y, black king x, black king y
+    uint64_t hash; // Zobrist hash of the position
+    uint64_t pawnHash; // Zobrist hash of the pawns alone, for the pawn table
+    int halfmoveClock; // moves since the last capture or pawn move
+    int fullmoveNumber; // starts at 1, goes up after each black move
+    // how far back a repetition can be, see KeyHistory: plies since the last capture, pawn move or null move, none of
+    // which can be undone
+    int repetitionPlies;
+    int psqScore; // sum of pieceSquare over all pieces
+    // first layer of the network for both sides, kept up to date move by move while a network is loaded. only valid
+    // if accumulatorGeneration matches Network::generation, otherwise eval recomputes it
+    Accumulator accumulator;
+    uint32_t accumulatorGeneration;
+
+    // tag for the constructor that leaves the board without pieces
+    struct EmptyBoard {};
+    explicit BoardState(EmptyBoard);
+
+    void putPiece(int sq, bool white, int id);
+    void removePiece(int sq);
+    void updateAccumulator(int sq, bool white, int id, bool add);
+    void refreshAccumulator(bool perspective);
+    Score staticEval(PawnTable *pawnTable);
+    Score networkEval();
+    uint64_t computeHash() const;
+    uint64_t castleAndEpKeys() const;
+    Bitboard attackersTo(int sq, bool white) const;
+    Bitboard attackersTo(int sq, bool white, Bitboard occupancy) const;
+    Bitboard pinnedPieces(int kingSq) const;
+    // which moves generate produces. captures include every promotion and en passant, quiets are all the rest
+    enum MoveType { allMoves, captureMoves, quietMoves };
+    void generate(MoveList &list, MoveType type, Bitboard fromMask = ~0ULL);
+    void addPawnMoves(MoveList &list, int from, int to);
+    void evalPawns(PawnEntry &entry) const;
+    int evalPieces(const PawnEntry &pawns) const;
+
+    // heuristic eval constants, in centipawns
+    constexpr const static int centerSquareVal = 10;
+    constexpr const static int pawnStructDeduct = 20;
+    constexpr const static int develop = 20;
+    constexpr const static int doubledPawnDeduct = 20;
+    //constexpr const static int safeKing = 100;
+    constexpr const static int openRook = 20;
+    constexpr const static int badBishop = 20;
+    constexpr const static int castledKing = 50;
+
+    // the parts of eval that only depend on which piece is on which square, added up move by move in psqScore
+    // instead of recounted at every eval. centipawns by piece (pieces order) and square, + for white
+    struct PieceSquareTable {
+        int value [12][64];
+    };
+    static constexpr PieceSquareTable makePieceSquareTable();
+    static const PieceSquareTable pieceSquare;
+};
 
-    std::vector<Move> moves;
-
-    // how many moves in the future we look with minimax
-    // depth 5 recommended for quick response
-    const static int searchDepth = 5;
+constexpr const int BoardState::pieceValue [7];
+
+// material, a bonus for every piece in the center and more for knights, and a bonus for a king that has left the
+// center files
+constexpr BoardState::PieceSquareTable BoardState::makePieceSquareTable() {
+    PieceSquareTable table{};
+    for(int i = 0; i < 12; i++) {
+        int id = i % 6 + 1;
+        int sign = i < 6 ? 1 : -1;
+        for(int sq = 0; sq < 64; sq++) {
+            int value = 100 * pieceValue[id];
+            if(centerSquares & bit(sq)) value += centerSquareVal + (id == 2 ? develop : 0);
+            if(id == 5 && (sq % 8 <= 2 || sq % 8 >= 6)) value += castledKing;
+            table.value[i][sq] = sign * value;
+        }
+    }
+    return table;
+}
 
-    // heuristic eval constants
-    constexpr const static auto centerSquareVal = 0.1;
-    constexpr const static auto pawnStructDeduct = 0.2;
-    constexpr const static auto develop = 0.2;
-    constexpr const static auto doubledPawnDeduct = 0.2;
-    //constexpr const static auto safeKing = 1;
-    constexpr const static auto openRook = .2;
-    constexpr const static auto badBishop = .2;
-};
+const BoardState::PieceSquareTable BoardState::pieceSquare = makePieceSquareTable();
 
 // creates a new board in standard configuration
 BoardState::BoardState() {
     whiteTurn = true;
+    epSquare = -1;
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    repetitionPlies = 0;
+    psqScore = 0;
+    pawnHash = 0;
+    accumulatorGeneration = 0;
     for (bool &i: canCastle) i = true;
     king[0] = 4;
     king[1] = 0;
     king[2] = 4;
     king[3] = 7;
 
-    bool w = true;
-    squares [0][0] = Square(w, 1);
-    squares [1][0] = Square(w, 2);
-    squares [2][0] = Square(w, 3);
-    squares [3][0] = Square(w, 4);
-    squares [4][0] = Square(w, 5);
-    squares [5][0] = Square(w, 3);
-    squares [6][0] = Square(w, 2);
-    squares [7][0] = Square(w, 1);
-
-    for(auto & square : squares) {
-        square[1] = Square(w, 6);
-        for(int i = 2; i < 6; i++) {
-            square[i] = Square();
+    const int backRank [8] = {1, 2, 3, 4, 5, 3, 2, 1};
+    for(int i = 0; i < 8; i++) {
+        putPiece(square(i, 0), true, backRank[i]);
+        putPiece(square(i, 1), true, 6);
+        putPiece(square(i, 6), false, 6);
+        putPiece(square(i, 7), false, backRank[i]);
+    }
+    hash = computeHash();
+}
+
+// board with no pieces, no castling rights and white to move. fromFEN fills it in
+BoardState::BoardState(EmptyBoard) {
+    whiteTurn = true;
+    epSquare = -1;
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    repetitionPlies = 0;
+    psqScore = 0;
+    hash = 0;
+    pawnHash = 0;
+    accumulatorGeneration = 0;
+}
+
+// builds the position described by a FEN string. the halfmove and fullmove counters may be left out, they then
+// default to 0 and 1. throws std::invalid_argument if the string can't be read
+BoardState BoardState::fromFEN(std::string_view fen) {
+    BoardState board{EmptyBoard()};
+    size_t i = 0;
+    // fields are split by any whitespace, so lines read from files can be passed with their line ending
+    auto space = [&fen](size_t at) {
+        return fen[at] == ' ' || fen[at] == '\t' || fen[at] == '\r' || fen[at] == '\n';
+    };
+    auto fail = [&fen](const char *what) {
+        throw std::invalid_argument(std::string("bad ") + what + " in FEN: " + std::string(fen));
+    };
+    // moves i to the start of the next field, returns false if there is none
+    auto nextField = [&fen, &i, &space]() {
+        while(i < fen.size() && !space(i)) i++;
+        while(i < fen.size() && space(i)) i++;
+        return i < fen.size();
+    };
+    auto readNumber = [&fen, &i, &fail, &space](const char *what) {
+        int n = 0;
+        size_t start = i;
+        for(; i < fen.size() && fen[i] >= '0' && fen[i] <= '9'; i++) {
+            if(n > 100000) fail(what);
+            n = 10 * n + fen[i] - '0';
+        }
+        if(i == start || (i < fen.size() && !space(i))) fail(what);
+        return n;
+    };
+
+    // ranks from 8 down to 1, files from a to h
+    while(i < fen.size() && space(i)) i++;
+    int x = 0, y = 7;
+    bool kingFound [2] = {false, false};
+    for(; i < fen.size() && !space(i); i++) {
+        char c = fen[i];
+        if(c == '/') {
+            if(x != 8 || y == 0) fail("rank");
+            x = 0;
+            y--;
+            continue;
+        }
+        if(c >= '1' && c <= '8') {
+            x += c - '0';
+        } else {
+            bool white = c >= 'A' && c <= 'Z';
+            int id;
+            switch (white ? c - 'A' + 'a' : c) {
+                case 'r': id = 1; break;
+                case 'n': id = 2; break;
+                case 'b': id = 3; break;
+                case 'q': id = 4; break;
+                case 'k': id = 5; break;
+                case 'p': id = 6; break;
+                default: id = 0; break;
+            }
+            if(id == 0 || x > 7) fail("piece placement");
+            if(id == 6 && (y == 0 || y == 7)) fail("pawn on the first or last rank");
+            board.putPiece(square(x, y), white, id);
+            if(id == 5) {
+                if(kingFound[white ? 0 : 1]) fail("king count");
+                kingFound[white ? 0 : 1] = true;
+                board.king[white ? 0 : 2] = x;
+                board.king[white ? 1 : 3] = y;
+            }
+            x++;
+        }
+        if(x > 8) fail("rank");
+    }
+    if(x != 8 || y != 0) fail("piece placement");
+    if(!kingFound[0] || !kingFound[1]) fail("king count");
+
+    if(!nextField() || (fen[i] != 'w' && fen[i] != 'b')) fail("side to move");
+    board.whiteTurn = fen[i] == 'w';
+
+    if(!nextField()) fail("castling rights");
+    if(fen[i] == '-') {
+        i++;
+    } else {
+        for(; i < fen.size() && !space(i); i++) {
+            switch (fen[i]) {
+                case 'K': board.canCastle[0] = true; break;
+                case 'Q': board.canCastle[1] = true; break;
+                case 'k': board.canCastle[2] = true; break;
+                case 'q': board.canCastle[3] = true; break;
+                default: fail("castling rights");
+            }
+        }
+    }
+    // a right only counts if king and rook are still on their squares, so makeMove never has to check
+    for(int right = 0; right < 4; right++) {
+        bool white = right < 2;
+        int back = white ? 0 : 56;
+        int rook = back + (right % 2 == 0 ? 7 : 0);
+        bool inPlace = (board.pieceBoard(white, 5) & bit(back + 4)) && (board.pieceBoard(white, 1) & bit(rook));
+        if(board.canCastle[right] && !inPlace) fail("castling rights");
+    }
+
+    if(!nextField()) fail("en passant square");
+    if(fen[i] != '-') {
+        if(i + 1 >= fen.size() || fen[i] < 'a' || fen[i] > 'h' || fen[i + 1] != (board.whiteTurn ? '6' : '3')) {
+            fail("en passant square");
         }
+        board.epSquare = square(fen[i] - 'a', fen[i + 1] - '1');
     }
 
-    w = false;
+    // the counters are optional
+    if(nextField()) {
+        board.halfmoveClock = readNumber("halfmove clock");
+        if(nextField()) {
+            board.fullmoveNumber = readNumber("fullmove number");
+            if(board.fullmoveNumber == 0) fail("fullmove number");
+            if(nextField()) fail("trailing field");
+        }
+    }
+
+    board.hash = board.computeHash();
+    return board;
+}
 
-    for(auto & square : squares) {
-        square[6] = Square(w, 6);
+// returns the position as a FEN string
+std::string BoardState::toFEN() const {
+    std::string fen;
+    fen.reserve(90);
+
+    const char letters [7] = {0, 'r', 'n', 'b', 'q', 'k', 'p'};
+    for(int y = 7; y >= 0; y--) {
+        int empty = 0;
+        for(int x = 0; x < 8; x++) {
+            int sq = square(x, y);
+            if(mailbox[sq] == 0) {
+                empty++;
+                continue;
+            }
+            if(empty > 0) fen.push_back(char('0' + empty));
+            empty = 0;
+            bool white = (occupied[0] & bit(sq)) != 0;
+            fen.push_back(char(white ? letters[mailbox[sq]] - 'a' + 'A' : letters[mailbox[sq]]));
+        }
+        if(empty > 0) fen.push_back(char('0' + empty));
+        if(y > 0) fen.push_back('/');
     }
 
-    squares [0][7] = Square(w, 1);
-    squares [1][7] = Square(w, 2);
-    squares [2][7] = Square(w, 3);
-    squares [3][7] = Square(w, 4);
-    squares [4][7] = Square(w, 5);
-    squares [5][7] = Square(w, 3);
-    squares [6][7] = Square(w, 2);
-    squares [7][7] = Square(w, 1);
+    fen += whiteTurn ? " w " : " b ";
+    size_t rights = fen.size();
+    for(int i = 0; i < 4; i++) {
+        if(canCastle[i]) fen.push_back("KQkq"[i]);
+    }
+    if(fen.size() == rights) fen.push_back('-');
+
+    fen.push_back(' ');
+    if(epSquare >= 0) {
+        fen.push_back(char('a' + epSquare % 8));
+        fen.push_back(char('1' + epSquare / 8));
+    } else {
+        fen.push_back('-');
+    }
 
-    getMoves();
+    fen += " " + std::to_string(halfmoveClock) + " " + std::to_string(fullmoveNumber);
+    return fen;
 }
 
 // prints out the board
@@ -107,8 +370,8 @@ std::string BoardState::display() {
         for(int i = 7; i >= 0; i--) {
             board.push_back('1' + i);
             board += " ";
-            for(auto & square : squares) {
-                board += square[i].toUni();
+            for(int j = 0; j < 8; j++) {
+                board += getSquare(j, i).toUni();
                 board += " ";
             }
             board += "\n";
@@ -123,7 +386,7 @@ std::string BoardState::display() {
             board.push_back('1' + i);
             board += " ";
             for(int j = 7; j >= 0; j--) {
-                board += squares[j][i].toUni();
+                board += getSquare(j, i).toUni();
                 board += " ";
             }
             board += "\n";
@@ -143,70 +406,173 @@ std::string BoardState::display() {
 // copies the board state to a new board, moves the piece on that board, then returns the resulting new board
 BoardState BoardState::movePiece(Move move) {
     auto newBoard = BoardState( * this);
-    // update king position
-    if(squares[move.ox][move.oy].id() == 5) {
-        newBoard.king[whiteTurn ? 0 : 2] = move.nx;
-        newBoard.king[whiteTurn ? 1 : 3] = move.ny;
+    newBoard.makeMove(move);
+    return newBoard;
+}
+
+// plays a move on this board in place. returns what unmakeMove needs to take it back
+Undo BoardState::makeMove(Move move) {
+    Undo undo;
+    undo.captured = 0;
+    undo.epSquare = epSquare;
+    for(int i = 0; i < 4; i++) {
+        undo.canCastle[i] = canCastle[i];
+        undo.king[i] = king[i];
+    }
+    undo.halfmoveClock = halfmoveClock;
+    undo.repetitionPlies = repetitionPlies;
+    undo.hash = hash;
+
+    int back = whiteTurn ? 0 : 56; // a1 or a8
+    hash ^= castleAndEpKeys();
+    epSquare = -1;
+    halfmoveClock++;
+    repetitionPlies++;
+    if(!whiteTurn) fullmoveNumber++;
+
+    // short castle
+    if(move.special() == 1) {
+        canCastle[whiteTurn ? 0 : 2] = false;
+        canCastle[whiteTurn ? 1 : 3] = false;
+        king[whiteTurn ? 0 : 2] = 6;
+        removePiece(back + 4);
+        removePiece(back + 7);
+        putPiece(back + 6, whiteTurn, 5);
+        putPiece(back + 5, whiteTurn, 1);
     }
-    // en passant
-    if(newBoard.squares[move.ox][move.oy].id() == 6 && newBoard.squares[move.nx][move.ny].id() == 0) {
-        newBoard.squares[move.nx][move.oy] = Square();
+    // long castle
+    if(move.special() == 2) {
+        canCastle[whiteTurn ? 0 : 2] = false;
+        canCastle[whiteTurn ? 1 : 3] = false;
+        king[whiteTurn ? 0 : 2] = 2;
+        removePiece(back + 4);
+        removePiece(back);
+        putPiece(back + 2, whiteTurn, 5);
+        putPiece(back + 3, whiteTurn, 1);
     }
-    // normal move
-    if(move.special == 0) {
-        // if moving rook a then no long castle
-        if(move.ox == 0 && move.oy == (whiteTurn ? 0 : 7) && squares[move.ox][move.oy].id() == 1) {
-            newBoard.canCastle[whiteTurn ? 1 : 3] = false;
+    // normal move or pawn promote
+    if(move.special() == 0 || move.special() > 2) {
+        int from = move.from();
+        int to = move.to();
+        int id = mailbox[from];
+
+        // en passant
+        if(id == 6 && to == undo.epSquare) {
+            removePiece(square(move.nx(), move.oy()));
+            undo.captured = 6;
+        } else if(mailbox[to] != 0) {
+            undo.captured = mailbox[to];
+            removePiece(to);
         }
-        // if moving rook h then no short castle
-        if(move.ox == 7 && move.oy == (whiteTurn ? 0 : 7) && squares[move.ox][move.oy].id() == 1) {
-            newBoard.canCastle[whiteTurn ? 0 : 2] = false;
+        removePiece(from);
+        putPiece(to, whiteTurn, move.special() > 2 ? move.special() - 2 : id);
+        if(id == 6 || undo.captured != 0) {
+            halfmoveClock = 0;
+            repetitionPlies = 0;
+        }
+
+        // update king position, if moving king then no castle
+        if(id == 5) {
+            king[whiteTurn ? 0 : 2] = move.nx();
+            king[whiteTurn ? 1 : 3] = move.ny();
+            canCastle[whiteTurn ? 0 : 2] = false;
+            canCastle[whiteTurn ? 1 : 3] = false;
         }
-        // if moving king then no castle
-        if(squares[move.ox][move.oy].id() == 5) {
-            newBoard.canCastle[whiteTurn ? 1 : 3] = false;
-            newBoard.canCastle[whiteTurn ? 0 : 2] = false;
+        // if a rook leaves or is taken on its corner then no castle on that side
+        for(int sq : {from, to}) {
+            if(sq == 7) canCastle[0] = false;
+            if(sq == 0) canCastle[1] = false;
+            if(sq == 63) canCastle[2] = false;
+            if(sq == 56) canCastle[3] = false;
+        }
+        // generate en passant takeable
+        if(id == 6 && abs(move.ny() - move.oy()) == 2) {
+            epSquare = square(move.ox(), (move.oy() + move.ny()) / 2);
         }
-        newBoard.squares[move.nx][move.ny] = Square(squares[move.ox][move.oy].isWhite(), squares[move.ox][move.oy].id());
-        newBoard.squares[move.ox][move.oy] = Square();
     }
-    // short castle
-    if(move.special == 1) {
-        newBoard.canCastle[whiteTurn ? 0 : 2] = false;
-        newBoard.canCastle[whiteTurn ? 1 : 3] = false;
-        newBoard.king[whiteTurn ? 0 : 2] = 6;
-        newBoard.squares[6][whiteTurn ? 0 : 7] = Square(whiteTurn, 5);
-        newBoard.squares[5][whiteTurn ? 0 : 7] = Square(whiteTurn, 1);
-        newBoard.squares[4][whiteTurn ? 0 : 7] = Square();
-        newBoard.squares[7][whiteTurn ? 0 : 7] = Square();
+
+    // the mover's inputs all depend on where its king stands
+    bool kingMoved = move.special() == 1 || move.special() == 2 || mailbox[move.to()] == 5;
+    if(kingMoved && Network::active() && accumulatorGeneration == Network::generation()) refreshAccumulator(whiteTurn);
+
+    whiteTurn = !whiteTurn;
+    hash ^= castleAndEpKeys() ^ zobrist.blackTurn;
+
+    return undo;
+}
+
+// takes back a move played with makeMove
+void BoardState::unmakeMove(Move move, Undo undo) {
+    whiteTurn = !whiteTurn;
+    int back = whiteTurn ? 0 : 56;
+
+    if(move.special() == 1) {
+        removePiece(back + 6);
+        removePiece(back + 5);
+        putPiece(back + 4, whiteTurn, 5);
+        putPiece(back + 7, whiteTurn, 1);
     }
-    // long castle
-    if(move.special == 2) {
-        newBoard.canCastle[whiteTurn ? 0 : 2] = false;
-        newBoard.canCastle[whiteTurn ? 1 : 3] = false;
-        newBoard.king[whiteTurn ? 0 : 2] = 2;
-        newBoard.squares[2][whiteTurn ? 0 : 7] = Square(whiteTurn, 5);
-        newBoard.squares[3][whiteTurn ? 0 : 7] = Square(whiteTurn, 1);
-        newBoard.squares[1][whiteTurn ? 0 : 7] = Square();
-        newBoard.squares[0][whiteTurn ? 0 : 7] = Square();
-        newBoard.squares[4][whiteTurn ? 0 : 7] = Square();
+    if(move.special() == 2) {
+        removePiece(back + 2);
+        removePiece(back + 3);
+        putPiece(back + 4, whiteTurn, 5);
+        putPiece(back, whiteTurn, 1);
     }
-    // generate en passant takeable
-    if(move.oy == (whiteTurn ? 1 : 6) && move.ny == (whiteTurn ? 3 : 4) && newBoard.squares[move.nx][move.ny].id() == 6) {
-        newBoard.squares[move.ox][whiteTurn ? 2 : 5] = Square(whiteTurn, -1);
+    bool kingMoved = move.special() == 1 || move.special() == 2;
+    if(move.special() == 0 || move.special() > 2) {
+        int from = move.from();
+        int to = move.to();
+        int id = move.special() > 2 ? 6 : mailbox[to];
+        kingMoved = id == 5;
+
+        removePiece(to);
+        putPiece(from, whiteTurn, id);
+        if(id == 6 && to == undo.epSquare) {
+            putPiece(square(move.nx(), move.oy()), !whiteTurn, 6);
+        } else if(undo.captured != 0) {
+            putPiece(to, !whiteTurn, undo.captured);
+        }
     }
+    if(kingMoved && Network::active() && accumulatorGeneration == Network::generation()) refreshAccumulator(whiteTurn);
 
-    // pawn promote
-    if(move.special > 2) {
-        newBoard.squares[move.nx][move.ny] = Square(whiteTurn, move.special - 2);
-        newBoard.squares[move.ox][move.oy] = Square();
+    epSquare = undo.epSquare;
+    for(int i = 0; i < 4; i++) {
+        canCastle[i] = undo.canCastle[i];
+        king[i] = undo.king[i];
     }
+    halfmoveClock = undo.halfmoveClock;
+    repetitionPlies = undo.repetitionPlies;
+    if(!whiteTurn) fullmoveNumber--;
+    hash = undo.hash;
+}
 
-    newBoard.whiteTurn = !newBoard.whiteTurn;
-
-    newBoard.getMoves();
+// passes the turn without moving, for null move pruning. only the en passant square, the clocks and the hash change.
+// no position before a null move counts as a repetition of one after it
+Undo BoardState::makeNullMove() {
+    Undo undo{};
+    undo.epSquare = int8_t(epSquare);
+    undo.halfmoveClock = halfmoveClock;
+    undo.repetitionPlies = repetitionPlies;
+    undo.hash = hash;
+    repetitionPlies = 0;
+
+    hash ^= castleAndEpKeys();
+    epSquare = -1;
+    hash ^= castleAndEpKeys() ^ zobrist.blackTurn;
+    halfmoveClock++;
+    if(!whiteTurn) fullmoveNumber++;
+    whiteTurn = !whiteTurn;
+    return undo;
+}
 
-    return newBoard;
+// takes back a move played with makeNullMove
+void BoardState::unmakeNullMove(Undo undo) {
+    whiteTurn = !whiteTurn;
+    if(!whiteTurn) fullmoveNumber--;
+    epSquare = undo.epSquare;
+    halfmoveClock = undo.halfmoveClock;
+    repetitionPlies = undo.repetitionPlies;
+    hash = undo.hash;
 }
 
 // returns whose turn it is; true if white, false if black
@@ -214,407 +580,310 @@ bool BoardState::isWhiteTurn() const{
     return whiteTurn;
 }
 
-// copy constructor
-BoardState::BoardState(const BoardState &old) {
-    for(int i = 0; i < 8; i++) {
-        for(int j = 0; j < 8; j++) {
-            if(old.squares[i][j].id() > -1) squares[i][j] = old.squares[i][j];
-        }
-    }
-    for(int i = 0; i < 4; i++) {
-        king[i] = old.king[i];
-        canCastle[i] = old.canCastle[i];
-    }
-    whiteTurn = old.whiteTurn;
+// bitboard of the pieces with the given color and id
+Bitboard BoardState::pieceBoard(bool white, int id) const {
+    return pieces[(white ? 0 : 6) + id - 1];
 }
 
-// verifies if the player-entered move is legal (not used for AI-generated move)
-bool BoardState::legalMove(Move move) {
-    // check for castles
-    if (move.special == 1) {
-        if(canCastle[whiteTurn ? 0 : 2]) {
-            return squares[5][whiteTurn ? 0 : 7].id() == 0 && squares[6][whiteTurn ? 0 : 7].id() == 0;
+// places a piece on an empty square
+void BoardState::putPiece(int sq, bool white, int id) {
+    pieces[(white ? 0 : 6) + id - 1] |= bit(sq);
+    occupied[white ? 0 : 1] |= bit(sq);
+    mailbox[sq] = id;
+    hash ^= zobrist.piece[(white ? 0 : 6) + id - 1][sq];
+    psqScore += pieceSquare.value[(white ? 0 : 6) + id - 1][sq];
+    if(id == 6) pawnHash ^= zobrist.piece[white ? 5 : 11][sq];
+    updateAccumulator(sq, white, id, true);
+}
+
+// clears a square, does nothing if it is already empty
+void BoardState::removePiece(int sq) {
+    if(mailbox[sq] == 0) return;
+    bool white = (occupied[0] & bit(sq)) != 0;
+    pieces[(white ? 0 : 6) + mailbox[sq] - 1] &= ~bit(sq);
+    occupied[white ? 0 : 1] &= ~bit(sq);
+    hash ^= zobrist.piece[(white ? 0 : 6) + mailbox[sq] - 1][sq];
+    psqScore -= pieceSquare.value[(white ? 0 : 6) + mailbox[sq] - 1][sq];
+    if(mailbox[sq] == 6) pawnHash ^= zobrist.piece[white ? 5 : 11][sq];
+    updateAccumulator(sq, white, mailbox[sq], false);
+    mailbox[sq] = 0;
+}
+
+// adds or takes away the inputs of a piece for both sides. kings aren't inputs, they choose which inputs the other
+// pieces are, so a king move refreshes its side with refreshAccumulator instead. while a king is off the board in
+// the middle of a move its side is skipped, it gets refreshed once the king is back
+void BoardState::updateAccumulator(int sq, bool white, int id, bool add) {
+    const Network *network = Network::active();
+    if(network == nullptr || accumulatorGeneration != Network::generation() || id == 5) return;
+    for(int c = 0; c < 2; c++) {
+        Bitboard kingBoard = pieceBoard(c == 0, 5);
+        if(!kingBoard) continue;
+        int feature = Network::feature(c == 0, lsb(kingBoard), white, id, sq);
+        if(add) {
+            network->addFeature(accumulator.values[c], feature);
         } else {
-            return false;
+            network->subFeature(accumulator.values[c], feature);
         }
     }
-    if (move.special == 2) {
-        if(canCastle[whiteTurn ? 1 : 3]) {
-            return squares[1][whiteTurn ? 0 : 7].id() == 0 && squares[2][whiteTurn ? 0 : 7].id() == 0
-            && squares[3][whiteTurn ? 0 : 7].id() == 0;
-        } else {
-            return false;
+}
+
+// recomputes one side's accumulator from every piece on the board
+void BoardState::refreshAccumulator(bool perspective) {
+    const Network *network = Network::active();
+    int16_t *values = accumulator.values[perspective ? 0 : 1];
+    int kingSq = lsb(pieceBoard(perspective, 5));
+    network->reset(values);
+    for(int i = 0; i < 12; i++) {
+        if(i % 6 == 4) continue;
+        for(Bitboard b = pieces[i]; b;) {
+            network->addFeature(values, Network::feature(perspective, kingSq, i < 6, i % 6 + 1, popLsb(b)));
         }
     }
-    // check for valid promotion
-    if(move.special > 2) {
-        if(move.ny != (whiteTurn ? 7 : 0)) return false;
-    }
-    // only allow pawns to en passant
-    if(squares[move.ox][move.oy].id() != 6 && squares[move.nx][move.ny].id() == -1) return false;
-    //check if piece doesn't move
-    if(move.nx == move.ox && move.ny == move.oy) return false;
-    // check if taking a piece of the same color
-    if(squares[move.nx][move.ny].id() != 0 && squares[move.nx][move.ny].isWhite() == whiteTurn) {
-        return false;
-    }
+}
 
-    // check geometry of move
-    switch (squares[move.ox][move.oy].id()) {
-        case 1: // check rook
-            if(move.nx != move.ox && move.ny != move.oy) return false;
-
-            if(move.ny == move.oy) {
-                for(int i = move.ox + ((move.nx - move.ox) > 0 ? 1 : -1);
-                i != move.nx + ((move.nx - move.ox) > 0 ? 1 : -1); i += ((move.nx - move.ox) > 0 ? 1 : -1)) {
-                    if(squares[i][move.oy].id() != 0) {
-                        if(i == move.nx) {
-                            if(squares[i][move.oy].isWhite() == whiteTurn) return false;
-                        } else {
-                            return false;
-                        }
-                    }
-                }
-            } else {
-                for(int i = move.oy + ((move.ny - move.oy) > 0 ? 1 : -1);
-                i != move.ny + ((move.ny - move.oy) > 0 ? 1 : -1); i += ((move.ny - move.oy) > 0 ? 1 : -1)) {
-                    if(squares[move.ox][i].id() != 0) {
-                        if(i == move.ny) {
-                            if(squares[move.ox][i].isWhite() == whiteTurn) return false;
-                        } else {
-                            return false;
-                        }
-                    }
-                }
-            }
-            break;
-        case 2: // check knight
-            if(!(abs(move.nx - move.ox) == 1 && abs(move.ny - move.oy) == 2)
-            && !(abs(move.nx - move.ox) == 2 && abs(move.ny - move.oy) == 1)) return false;
-
-            if(squares[move.nx][move.ny].id() != 0
-            && squares[move.nx][move.ny].isWhite() == whiteTurn) return false;
-
-            break;
-        case 3: // check bishop
-            if(abs(move.nx - move.ox) - abs(move.ny - move.oy) != 0) return false;
-            for(int i = 1; i <= abs(move.nx - move.ox); i++) {
-                if(squares[move.ox + i * (move.nx > move.ox ? 1 : -1)]
-                [move.oy + i * (move.ny > move.oy ? 1 : -1)].id() != 0) {
-                    if(move.ox + i * (move.nx > move.ox ? 1 : -1) == move.nx) {
-                        if(squares[move.ox + i * (move.nx > move.ox ? 1 : -1)]
-                        [move.oy + i * (move.ny > move.oy ? 1 : -1)].isWhite() == whiteTurn) return false;
-                    } else {
-                        return false;
-                    }
-                }
-            }
-            break;
-        case 4: // check queen
-            if(move.nx == move.ox || move.ny == move.oy) { //check rook moves
-                if(move.ny == move.oy) {
-                    for(int i = move.ox + 1; i <= move.nx; i += move.nx - move.ox > 0 ? 1 : -1) {
-                        if(squares[i][move.oy].id() != 0) {
-                            if(i == move.nx) {
-                                if(squares[i][move.oy].isWhite() == whiteTurn) return false;
-                            } else {
-                                return false;
-                            }
-                        }
-                    }
-                } else {
-                    for(int i = move.oy + 1; i <= move.ny; i += move.ny - move.oy > 0 ? 1 : -1) {
-                        if(squares[move.ox][i].id() != 0) {
-                            if(i == move.ny) {
-                                if(squares[move.ox][i].isWhite() == whiteTurn) return false;
-                            } else {
-                                return false;
-                            }
-                        }
-                    }
-                }
-            } else if(abs(move.nx - move.ox) - abs(move.ny - move.oy) == 0) { // check bishop moves
-                for(int i = 1; i <= abs(move.nx - move.ox); i++) {
-                    if(squares[move.ox + i * (move.nx > move.ox ? 1 : -1)]
-                       [move.oy + i * (move.ny > move.oy ? 1 : -1)].id() != 0) {
-                        if(move.ox + i * (move.nx > move.ox ? 1 : -1) == move.nx) {
-                            if(squares[move.ox + i * (move.nx > move.ox ? 1 : -1)]
-                               [move.oy + i * (move.ny > move.oy ? 1 : -1)].isWhite() == whiteTurn) return false;
-                        } else {
-                            return false;
-                        }
-                    }
-                }
-            } else {
-                return false;
-            }
-            break;
-        case 5: // check king
-            if(abs(move.nx - move.ox) > 1 || abs(move.ny - move.oy) > 1) return false;
-
-            if(squares[move.nx][move.ny].id() != 0
-               && squares[move.nx][move.ny].isWhite() == whiteTurn) return false;
-
-            break;
-        case 6: // check pawn
-            if(move.ox == move.nx) {
-                if(squares[move.nx][move.ny].id() > 0) return false;
-                if(move.ny - move.oy != (whiteTurn ? 1 : -1)) {
-                    if(move.ny - move.oy == (whiteTurn ? 2 : -2)) {
-                        if(move.oy != (whiteTurn ? 1 : 6)) return false;
-                        if(squares[move.ox][move.oy + (whiteTurn ? 1 : -1)].id() != 0) return false;
-                    } else {
-                        return false;
-                    }
-                }
-            } else {
-                if(move.nx - move.ox == 1 || move.nx - move.ox == -1) {
-                    if(move.ny - move.oy != (whiteTurn ? 1 : -1)) return false;
-                    if(squares[move.nx][move.ny].isWhite() == whiteTurn
-                    || squares[move.nx][move.ny].id() == 0) return false;
-                } else {
-                    return false;
-                }
-            }
-            break;
-        default:
-            break;
+// eval by the loaded network, + for white like eval
+Score BoardState::networkEval() {
+    if(accumulatorGeneration != Network::generation()) {
+        refreshAccumulator(true);
+        refreshAccumulator(false);
+        accumulatorGeneration = Network::generation();
     }
+    const int16_t *own = accumulator.values[whiteTurn ? 0 : 1];
+    const int16_t *other = accumulator.values[whiteTurn ? 1 : 0];
+    int score = Network::active()->evaluate(own, other);
+    return whiteTurn ? score : -score;
+}
 
-    // check if your king is in check after move
-    if(movePiece(move).inCheck(whiteTurn)) {
-        return false;
+// hash of the whole position from scratch
+uint64_t BoardState::computeHash() const {
+    uint64_t h = castleAndEpKeys() ^ (whiteTurn ? 0 : zobrist.blackTurn);
+    for(int i = 0; i < 12; i++) {
+        for(Bitboard b = pieces[i]; b;) {
+            h ^= zobrist.piece[i][popLsb(b)];
+        }
     }
+    return h;
+}
 
-    return true;
+// keys for the current castling rights and en passant file
+uint64_t BoardState::castleAndEpKeys() const {
+    uint64_t h = 0;
+    for(int i = 0; i < 4; i++) {
+        if(canCastle[i]) h ^= zobrist.castle[i];
+    }
+    if(epSquare >= 0) h ^= zobrist.enPassant[epSquare % 8];
+    return h;
 }
 
-// returns Square object at specified coordinates
-Square BoardState::getSquare(int x, int y){
-    return squares[x][y];
+// returns the Zobrist hash of the position
+uint64_t BoardState::getHash() const {
+    return hash;
 }
 
-// returns true if specified player is in check
-bool BoardState::inCheck(bool white) {
-    int x = king[(white ? 0 : 2)];
-    int y = king[(white ? 1 : 3)];
-    if(abs(king[0] - king[1]) <= 1 && abs(king[2] - king[3]) <= 1) return true;
-    // check up
-    for(int i = y; i < 8; i++) {
-        if(i != y) {
-            if((squares[x][i].isWhite() == white || (squares[x][i].id() != 1 && squares[x][i].id() != 4)) && squares[x][i].id() > 0) break;
-            if ((squares[x][i].id() == 1 || squares[x][i].id() == 4)
-                && squares[x][i].isWhite() == !white) return true;
+// hash of the position the way Polyglot opening books key it, from polyglotRandom. en passant only counts if a pawn of
+// the side to move stands ready to take
+uint64_t BoardState::polyglotKey() const {
+    // Polyglot kind of each piece id, for black. white is one more
+    const int kind [7] = {0, 6, 2, 4, 8, 10, 0};
+    uint64_t key = 0;
+    for(int i = 0; i < 12; i++) {
+        bool white = i < 6;
+        for(Bitboard b = pieces[i]; b;) {
+            key ^= polyglotRandom[64 * (kind[i % 6 + 1] + (white ? 1 : 0)) + popLsb(b)];
         }
     }
-    // check down
-    for(int i = y; i >= 0; i--) {
-        if(i != y) {
-            if((squares[x][i].isWhite() == white || (squares[x][i].id() != 1 && squares[x][i].id() != 4)) && squares[x][i].id() > 0) break;
-            if ((squares[x][i].id() == 1 || squares[x][i].id() == 4)
-                && squares[x][i].isWhite() == !white) return true;
-        }
-    }
-    // check right
-    for(int i = x; i < 8; i++) {
-        if(i != x) {
-            if((squares[i][y].isWhite() == white || (squares[i][y].id() != 1 && squares[i][y].id() != 4)) && squares[i][y].id() > 0) break;
-            if ((squares[i][y].id() == 1 || squares[i][y].id() == 4)
-                && squares[i][y].isWhite() == !white) return true;
-        }
-    }
-    // check left
-    for(int i = x; i >= 0; i--) {
-        if(i != x) {
-            if((squares[i][y].isWhite() == white  || (squares[i][y].id() != 1 && squares[i][y].id() != 4)) && squares[i][y].id() > 0) break;
-            if ((squares[i][y].id() == 1 || squares[i][y].id() == 4)
-                && squares[i][y].isWhite() == !white) return true;
-        }
-    }
-    // check up right
-    for(int i = 1; i < 8; i++) {
-        if(i + y > 7 || i + x > 7) break;
-        if((squares[i + x][i + y].isWhite() == white || (squares[x + i][y + i].id() != 3 && squares[x + i][y + i].id() != 4))
-           && squares[i + x][i + y].id() > 0) break;
-        if ((squares[i + x][i + y].id() == 3 || squares[i + x][i + y].id() == 4)
-            && squares[i + x][i + y].isWhite() == !white) return true;
+    for(int i = 0; i < 4; i++) {
+        if(canCastle[i]) key ^= polyglotRandom[768 + i];
     }
-    // check down right
-    for(int i = 1; i < 8; i++) {
-        if(y - i < 0 || i + x > 7) break;
-        if((squares[x + i][y - i].isWhite() == white || (squares[x + i][y - i].id() != 3 && squares[x + i][y - i].id() != 4))
-           && squares[x + i][y - i].id() > 0) break;
-        if ((squares[x + i][y - i].id() == 3 || squares[x + i][y - i].id() == 4)
-            && squares[x + i][y - i].isWhite() == !white) return true;
+    if(epSquare >= 0 && (attackTables.pawn[whiteTurn ? 1 : 0][epSquare] & pieceBoard(whiteTurn, 6))) {
+        key ^= polyglotRandom[772 + epSquare % 8];
     }
-    // check up left
-    for(int i = 1; i < 8; i++) {
-        if(y + i > 7 || x - i < 0) break;
-        if((squares[x - i][y + i].isWhite() == white || (squares[x - i][y + i].id() != 3 && squares[x - i][y + i].id() != 4))
-           && squares[x - i][y + i].id() > 0) break;
-        if ((squares[x - i][y + i].id() == 3 || squares[x - i][y + i].id() == 4)
-            && squares[x - i][y + i].isWhite() == !white) return true;
+    if(whiteTurn) key ^= polyglotRandom[780];
+    return key;
+}
+
+// returns the pieces of the given color that attack a square
+Bitboard BoardState::attackersTo(int sq, bool white) const {
+    return attackersTo(sq, white, occupied[0] | occupied[1]);
+}
+
+// same, with sliders blocked by the given occupancy instead of the pieces on the board
+Bitboard BoardState::attackersTo(int sq, bool white, Bitboard occupancy) const {
+    return (attackTables.knight[sq] & pieceBoard(white, 2))
+    | (attackTables.king[sq] & pieceBoard(white, 5))
+    | (attackTables.pawn[white ? 1 : 0][sq] & pieceBoard(white, 6))
+    | (attackTables.rook(sq, occupancy) & (pieceBoard(white, 1) | pieceBoard(white, 4)))
+    | (attackTables.bishop(sq, occupancy) & (pieceBoard(white, 3) | pieceBoard(white, 4)));
+}
+
+// verifies if a move is legal here. only the moves of the piece on the move's start square are generated, so this is
+// cheap enough for the search to check hash moves and killers with
+bool BoardState::legalMove(Move move) {
+    if(move.special() == -1) return false;
+    bool castle = move.special() == 1 || move.special() == 2;
+    MoveList list;
+    generate(list, allMoves, castle ? pieceBoard(whiteTurn, 5) : bit(move.from()));
+    for(auto m : list) {
+        if(m == move) return true;
     }
-    // check down left
-    for(int i = 1; i < 8; i++) {
-        if(y - i < 0 || x - i < 0) break;
-        if ((squares[x - i][y - i].isWhite() == white ||
-             (squares[x - i][y - i].id() != 3 && squares[x - i][y - i].id() != 4))
-            && squares[x - i][y - i].id() > 0) break;
-        if ((squares[x - i][y - i].id() == 3 || squares[x - i][y - i].id() == 4)
-            && squares[x - i][y - i].isWhite() == !white) return true;
+    return false;
+}
+
+// returns Square object at specified coordinates
+Square BoardState::getSquare(int x, int y){
+    int sq = square(x, y);
+    if(sq == epSquare) return {!whiteTurn, -1};
+    if(mailbox[sq] == 0) return {};
+    return {(occupied[0] & bit(sq)) != 0, mailbox[sq]};
+}
+
+// returns the id of the piece on a square, 0 if empty
+int BoardState::pieceAt(int sq) const {
+    return mailbox[sq];
+}
+
+// true if the move takes a piece, including en passant
+bool BoardState::isCapture(Move move) const {
+    return capturedPiece(move) != 0;
+}
+
+// id of the piece the move takes, 0 if none
+int BoardState::capturedPiece(Move move) const {
+    if(move.special() == -1 || move.special() == 1 || move.special() == 2) return 0;
+    int to = move.to();
+    if(to == epSquare && mailbox[move.from()] == 6) return 6;
+    return mailbox[to];
+}
+
+// material of the rooks, knights, bishops and queens of one side, in pawns. 0 means king and pawns only, where
+// passing is often the best move
+int BoardState::pieceMaterial(bool white) const {
+    int material = 0;
+    for(int id = 1; id <= 4; id++) {
+        material += pieceValue[id] * popCount(pieceBoard(white, id));
     }
-    // check for knight attacks
-    if(x < 7 && y < 6 && squares[x + 1][y + 2].id() == 2 && squares[x + 1][y + 2].isWhite() == !white) return true;
-    if(x > 0 && y < 6 && squares[x - 1][y + 2].id() == 2 && squares[x - 1][y + 2].isWhite() == !white) return true;
-    if(x < 7 && y > 1 && squares[x + 1][y - 2].id() == 2 && squares[x + 1][y - 2].isWhite() == !white) return true;
-    if(x > 0 && y > 1 && squares[x - 1][y - 2].id() == 2 && squares[x - 1][y - 2].isWhite() == !white) return true;
-    if(x < 6 && y < 7 && squares[x + 2][y + 1].id() == 2 && squares[x + 2][y + 1].isWhite() == !white) return true;
-    if(x > 1 && y < 7 && squares[x - 2][y + 1].id() == 2 && squares[x - 2][y + 1].isWhite() == !white) return true;
-    if(x < 6 && y > 0 && squares[x + 2][y - 1].id() == 2 && squares[x + 2][y - 1].isWhite() == !white) return true;
-    if(x > 1 && y > 0 && squares[x - 2][y - 1].id() == 2 && squares[x - 2][y - 1].isWhite() == !white) return true;
-    //check for pawn attacks
-    if(squares[x + 1][y + (white ? 1 : -1)].isWhite() == !white
-    && squares[x + 1][y + (white ? 1 : -1)].id() == 6) return true;
-    if(squares[x - 1][y + (white ? 1 : -1)].isWhite() == !white
-       && squares[x - 1][y + (white ? 1 : -1)].id() == 6) return true;
+    return material;
+}
 
-    return false;
+// number of pieces on the board, kings and pawns included
+int BoardState::pieceCount() const {
+    return popCount(occupied[0] | occupied[1]);
 }
 
-// evaluates the board state, + for white, - for black
-double BoardState::eval() {
-    int wFile [8];
-    int bFile [8];
-    int wRooks [8];
-    int bRooks [8];
-    double total = 0;
-    int freedom;
+// true if either side may still castle
+bool BoardState::hasCastlingRights() const {
+    return canCastle[0] || canCastle[1] || canCastle[2] || canCastle[3];
+}
 
-    // count pieces, analyze pawn structure and open files
-    for(int i = 0; i < 8; i++) {
-        wFile[i] = 0;
-        bFile[i] = 0;
-        wRooks[i] = 0;
-        bRooks[i] = 0;
-        for(int j = 0; j < 8; j++) {
-            Square square = squares[i][j];
-            switch (square.id()) {
-                case 0:
-                    break;
-                case 1:
-                    if((i < 7 && (whiteTurn ? j > 0 : j < 7) && squares[i + 1][j - (whiteTurn ? 1 : -1)].id() == 6 &&
-                    squares[i + 1][j - (whiteTurn ? 1 : -1)].isWhite() != square.isWhite()) ||
-                    (i > 0 && (whiteTurn ? j > 0 : j < 7) && squares[i - 1][j - (whiteTurn ? 1 : -1)].id() == 6 &&
-                    squares[i - 1][j - (whiteTurn ? 1 : -1)].isWhite() != square.isWhite())) {
-                        total -= (square.isWhite() ? 5 : -5);
-                    }
-                    if(square.isWhite()) {
-                        wRooks[i]++;
-                    } else {
-                        bRooks[i]++;
-                    }
-                    total += (square.isWhite() ? 5 : -5);
-                    break;
-                case 2:
-                    if((i < 7 && (whiteTurn ? j > 0 : j < 7) && squares[i + 1][j - (whiteTurn ? 1 : -1)].id() == 6 &&
-                        squares[i + 1][j - (whiteTurn ? 1 : -1)].isWhite() != square.isWhite()) ||
-                       (i > 0 && (whiteTurn ? j > 0 : j < 7) && squares[i - 1][j - (whiteTurn ? 1 : -1)].id() == 6 &&
-                        squares[i - 1][j - (whiteTurn ? 1 : -1)].isWhite() != square.isWhite())) {
-                        total -= (square.isWhite() ? 3 : -3);
-                    }
-                    total += (square.isWhite() ? 3 : -3);
-                    break;
-                case 3:
-                    if((i < 7 && (whiteTurn ? j > 0 : j < 7) && squares[i + 1][j - (whiteTurn ? 1 : -1)].id() == 6 &&
-                        squares[i + 1][j - (whiteTurn ? 1 : -1)].isWhite() != square.isWhite()) ||
-                       (i > 0 && (whiteTurn ? j > 0 : j < 7) && squares[i - 1][j - (whiteTurn ? 1 : -1)].id() == 6 &&
-                        squares[i - 1][j - (whiteTurn ? 1 : -1)].isWhite() != square.isWhite())) {
-                        total -= (square.isWhite() ? 3 : -3);
-                    }
-                    freedom = 0;
-                    if(i < 7) {
-                        if(j < 7 && squares[i + 1][j + 1].id() == 0) freedom++;
-                        if(j > 0 && squares[i + 1][j - 1].id() == 0) freedom++;
-                    }
-                    if(i > 0) {
-                        if(j < 7 && squares[i - 1][j + 1].id() == 0) freedom++;
-                        if(j > 0 && squares[i - 1][j - 1].id() == 0) freedom++;
-                    }
-
-                    if(freedom == 0) {
-                        total -= 2 * badBishop * (square.isWhite() ? 1 : -1);
-                    } else if(freedom == 1) {
-                        total -= badBishop * (square.isWhite() ? 1 : -1);
-                    }
-
-                    total += (square.isWhite() ? 3 : -3);
-                    break;
-                case 4:
-                    if((i < 7 && (whiteTurn ? j > 0 : j < 7) && squares[i + 1][j - (whiteTurn ? 1 : -1)].id() == 6 &&
-                        squares[i + 1][j - (whiteTurn ? 1 : -1)].isWhite() != square.isWhite()) ||
-                       (i > 0 && (whiteTurn ? j > 0 : j < 7) && squares[i - 1][j - (whiteTurn ? 1 : -1)].id() == 6 &&
-                        squares[i - 1][j - (whiteTurn ? 1 : -1)].isWhite() != square.isWhite())) {
-                        total -= (square.isWhite() ? 9 : -9);
-                    }
-                    total += (square.isWhite() ? 9 : -9);
-                    break;
-                case 6:
-                    if((i < 7 && (whiteTurn ? j > 0 : j < 7) && squares[i + 1][j - (whiteTurn ? 1 : -1)].id() == 6 &&
-                        squares[i + 1][j - (whiteTurn ? 1 : -1)].isWhite() != square.isWhite()) ||
-                       (i > 0 && (whiteTurn ? j > 0 : j < 7) && squares[i - 1][j - (whiteTurn ? 1 : -1)].id() == 6 &&
-                        squares[i - 1][j - (whiteTurn ? 1 : -1)].isWhite() != square.isWhite())) {
-                        total -= (square.isWhite() ? 1 : -1);
-                    }
-                    if(square.isWhite()) {
-                        wFile[i]++;
-                    } else {
-                        bFile[i]++;
-                    }
-                    total += (square.isWhite() ? 1 : -1);
-                    if(i != (square.isWhite() ? 1 : 6)) {
-                        Square l = squares[i - 1][j - (square.isWhite() ? 1 : -1)];
-                        Square r = squares[i + 1][j - (square.isWhite() ? 1 : -1)];
-                        if(!(l.isWhite() == square.isWhite() && l.id() == 6) && !(r.isWhite() == square.isWhite() && r.id() == 6)) {
-                            total -= pawnStructDeduct * (square.isWhite() ? 1 : -1);
-                        }
-                    }
-                    break;
-                default:
-                    break;
-            }
+// moves since the last capture or pawn move
+int BoardState::getHalfmoveClock() const {
+    return halfmoveClock;
+}
+
+// plies since the last capture, pawn move or null move
+int BoardState::getRepetitionPlies() const {
+    return repetitionPlies;
+}
+
+// true if fifty moves have passed without a capture or pawn move, which is a draw unless the last one checkmated
+bool BoardState::fiftyMoveDraw() {
+    return halfmoveClock >= 100 && !checkmate();
+}
+
+// returns true if specified player is in check
+bool BoardState::inCheck(bool white) {
+    return attackersTo(square(king[white ? 0 : 2], king[white ? 1 : 3]), !white) != 0;
+}
+
+// evaluates the board state in centipawns, + for white, - for black. material and square bonuses come from psqScore,
+// only the terms that depend on how the pieces stand to each other are counted here
+Score BoardState::eval() {
+    return staticEval(nullptr);
+}
+
+// same as eval, but the pawn structure is looked up in the pawn table and only scored on a miss
+Score BoardState::eval(PawnTable &pawnTable) {
+    return staticEval(&pawnTable);
+}
+
+// eval by the network if one is loaded, otherwise by hand. every eval passes through here and is clamped to
+// maxEvalScore, so neither evaluator can reach the tablebase and mate scores search reads plies from
+Score BoardState::staticEval(PawnTable *pawnTable) {
+    Score score;
+    if(Network::active()) {
+        score = networkEval();
+    } else if(pawnTable == nullptr) {
+        PawnEntry pawns;
+        evalPawns(pawns);
+        score = evalPieces(pawns);
+    } else {
+        PawnEntry *pawns;
+        if(!pawnTable->probe(pawnHash, pawns)) {
+            evalPawns(*pawns);
+            pawns->key = pawnHash;
         }
+        score = evalPieces(*pawns);
     }
+    return std::max(-maxEvalScore, std::min(score, maxEvalScore));
+}
+
+// the terms of eval that only depend on where the pawns are
+void BoardState::evalPawns(PawnEntry &entry) const {
+    entry.score = 0;
+    for(int c = 0; c < 2; c++) {
+        bool white = c == 0;
+        int sign = white ? 1 : -1;
+        Bitboard pawns = pieceBoard(white, 6);
 
-    // check central squares
-    for(int i = 2; i < 6; i++) {
-        for(int j = 2; j < 6; j++) {
-            int id = squares[i][j].id();
-            if(id > 0) total += centerSquareVal * (squares[i][j].isWhite() ? 1 : -1);
-            if(id == 2) {
-                total += develop * (squares[i][j].isWhite() ? 1 : -1);
+        // pawns that have left their starting rank without another pawn protecting them
+        Bitboard loose = pawns & ~pawnAttacks(pawns, white) & ~(white ? rank2 : rank7);
+        entry.score -= pawnStructDeduct * sign * popCount(loose);
+
+        // doubled pawns, and files without pawns for the rooks
+        entry.openFiles[c] = 0;
+        for(int i = 0; i < 8; i++) {
+            int filePawns = popCount(pawns & (fileA << i));
+            if(filePawns > 1) {
+                entry.score -= doubledPawnDeduct * sign * (filePawns - 1);
+            } else if(filePawns == 0) {
+                entry.openFiles[c] |= 1 << i;
             }
         }
     }
+}
 
-    // check files
-    for(int i = 0; i < 8; i++) {
-        if (wFile[i] > 1) {
-            total -= doubledPawnDeduct * (wFile[i] - 1);
-        } else if(wFile[i] == 0) {
-            total += openRook * wRooks[i];
-        }
-        if (bFile[i] > 1) {
-            total += doubledPawnDeduct * (wFile[i] - 1);
-        } else if(bFile[i] == 0) {
-            total -= openRook * bRooks[i];
-        }
+// everything in eval besides the pawn structure, which is passed in
+int BoardState::evalPieces(const PawnEntry &pawns) const {
+    int total = psqScore + pawns.score;
+    Bitboard all = occupied[0] | occupied[1];
+
+    // pieces attacked by a pawn of the side to move are about to be lost so they don't count
+    bool waiting = !whiteTurn;
+    Bitboard hanging = pawnAttacks(pieceBoard(whiteTurn, 6), whiteTurn) & occupied[waiting ? 0 : 1];
+    for(int id = 1; id <= 6; id++) {
+        total -= (waiting ? 1 : -1) * 100 * pieceValue[id] * popCount(pieceBoard(waiting, id) & hanging);
     }
 
-    if(king[0] <= 2 || king[0] >= 6) total += .5;
-    if(king[2] <= 2 || king[2] >= 6) total -= .5;
+    for(int c = 0; c < 2; c++) {
+        bool white = c == 0;
+        int sign = white ? 1 : -1;
+
+        // bishops blocked in on their diagonals
+        for(Bitboard bishops = pieceBoard(white, 3); bishops;) {
+            Bitboard b = bit(popLsb(bishops));
+            int freedom = popCount((northEast(b) | northWest(b) | southEast(b) | southWest(b)) & ~all);
+            if(freedom == 0) {
+                total -= 2 * badBishop * sign;
+            } else if(freedom == 1) {
+                total -= badBishop * sign;
+            }
+        }
 
-    if(fabs(total) < .05) total = 0;
+        // rooks on files without a pawn of their own. the mask times fileA spreads each file bit up its file
+        total += openRook * sign * popCount(pieceBoard(white, 1) & (pawns.openFiles[c] * fileA));
+    }
+
+    if(abs(total) < 5) total = 0;
 
     return total;
 }
@@ -627,439 +896,187 @@ bool BoardState::operator()(const Move &move1, const Move &move2)
     return whiteTurn == higher;
 }
 
-// method to find the best move from the current board state. uses recursive helper method
-Move BoardState::bestMove() {
-
-    Move best = moves[0];
-    double alpha = -DBL_MAX;
-    double beta = DBL_MAX;
-    if(whiteTurn) {
-        double maxEval = -DBL_MAX;
-        for(auto move : moves) {
-            double eval = minimax(movePiece(move), searchDepth - 1, alpha, beta);
-            std::cout << movePiece(move).eval() << " -> " << eval << "\n";
-            if(eval > maxEval && legalMove(move)) {
-                std::cout << "\nnew max " << move.ox << move.oy << " " << move.nx << move.ny << " : " << eval << "\n";
-                maxEval = eval;
-                best = move;
-            }
-            alpha = std::max(eval, alpha);
-            if(beta <= alpha) break;
-        }
-        return best;
-    } else {
-        double minEval = DBL_MAX;
-        for(auto move : moves) {
-            double eval = minimax(movePiece(move), searchDepth - 1, alpha, beta);
-            std::cout << movePiece(move).eval() << " -> " << eval << "\n";
-            if(eval < minEval  && legalMove(move)) {
-                std::cout << "\nnew min " << move.ox << move.oy << " " << move.nx << move.ny << " : " << eval << "\n";
-                minEval = eval;
-                best = move;
-            }
-            beta = std::min(eval, beta);
-            if(beta <= alpha) break;
-        }
-        return best;
-    }
+// checks if game is over, ends the program when true
+bool BoardState::checkmate() {
+    MoveList list;
+    generateMoves(list);
+    return list.empty() && inCheck(whiteTurn);
 }
 
-// minimax with alpha beta pruning
-double BoardState::minimax(BoardState current, int depth, double alpha, double beta) {
-
-    if(current.inCheck(current.whiteTurn) && checkmate()) return (current.whiteTurn ? -100 : 100);
+// appends the legal moves of the side to move to list
+void BoardState::generateMoves(MoveList &list) {
+    generate(list, allMoves);
+}
 
-    if(current.inCheck(!current.whiteTurn)) return DBL_MAX * (current.whiteTurn ? 1 : -1);
+// appends only the legal captures and promotions, for quiescence search and the first stage of the move picker
+void BoardState::generateCaptures(MoveList &list) {
+    generate(list, captureMoves);
+}
 
-    if(current.moves.empty() || depth == 0) return current.eval();
+// appends the legal moves generateCaptures leaves out, for when the move picker runs out of captures
+void BoardState::generateQuiets(MoveList &list) {
+    generate(list, quietMoves);
+}
 
-    if(current.whiteTurn) {
-        double maxEval = -DBL_MAX;
-        for(auto move : current.moves) {
-            double eval = minimax(current.movePiece(move), depth - 1, alpha, beta);
-            maxEval = std::max(eval, maxEval);
-            alpha = std::max(eval, alpha);
-            if(beta <= alpha) break;
+// move generation shared by generateMoves, generateCaptures and generateQuiets. only legal moves are generated: the
+// king never steps onto an attacked square, pinned pieces only move along their pin, and in check every other move has
+// to take the checking piece or block it. fromMask limits generation to the pieces on those squares
+void BoardState::generate(MoveList &list, MoveType type, Bitboard fromMask) {
+
+    Bitboard own = occupied[whiteTurn ? 0 : 1];
+    Bitboard enemy = occupied[whiteTurn ? 1 : 0];
+    Bitboard all = own | enemy;
+    Bitboard targets = type == captureMoves ? enemy : type == quietMoves ? ~all : ~own;
+    int back = whiteTurn ? 0 : 56;
+    int kingSq = lsb(pieceBoard(whiteTurn, 5));
+    bool kingMoves = fromMask & bit(kingSq);
+
+    // king moves are tested with the king off the board, so it can't step back along the ray of a checking slider
+    for(Bitboard b = kingMoves ? attackTables.king[kingSq] & targets : 0; b;) {
+        int to = popLsb(b);
+        if(!attackersTo(to, !whiteTurn, all ^ bit(kingSq))) {
+            list.add(Move(kingSq, to, 0));
         }
+    }
 
-        return maxEval;
-    } else {
-        double minEval = DBL_MAX;
-        for(auto move : current.moves) {
-            double eval = minimax(current.movePiece(move), depth - 1, alpha, beta);
-            minEval = std::min(eval, minEval);
-            beta = std::min(eval, beta);
-            if(beta <= alpha) break;
+    // in double check only the king can move
+    Bitboard checkers = attackersTo(kingSq, !whiteTurn);
+    if(popCount(checkers) > 1) return;
+
+    // squares the other pieces may move to. in check that is the checking piece or a square between it and the king
+    Bitboard checkMask = checkers ? checkers | attackTables.between[kingSq][lsb(checkers)] : ~0ULL;
+    Bitboard pinned = pinnedPieces(kingSq);
+    // a pinned piece stays on the line through its king and the pinning piece
+    auto allowed = [this, pinned, kingSq](int from, int to) {
+        return !(pinned & bit(from)) || (attackTables.line[kingSq][from] & bit(to));
+    };
+
+    // castles need empty squares between king and rook, and the king can't castle out of or through check
+    bool castles = kingMoves && type != captureMoves && !checkers;
+    if(castles && canCastle[whiteTurn ? 0 : 2] && !(all & (bit(back + 5) | bit(back + 6)))
+    && !attackersTo(back + 5, !whiteTurn) && !attackersTo(back + 6, !whiteTurn)) list.add(Move("O-O"));
+    if(castles && canCastle[whiteTurn ? 1 : 3]
+    && !(all & (bit(back + 1) | bit(back + 2) | bit(back + 3)))
+    && !attackersTo(back + 3, !whiteTurn) && !attackersTo(back + 2, !whiteTurn)) list.add(Move("O-O-O"));
+
+    // rook, knight, bishop, queen
+    for(int id = 1; id <= 4; id++) {
+        for(Bitboard b = pieceBoard(whiteTurn, id) & fromMask; b;) {
+            int from = popLsb(b);
+            Bitboard attacks;
+            switch (id) {
+                case 1:
+                    attacks = attackTables.rook(from, all);
+                    break;
+                case 2:
+                    attacks = attackTables.knight[from];
+                    break;
+                case 3:
+                    attacks = attackTables.bishop(from, all);
+                    break;
+                default:
+                    attacks = attackTables.queen(from, all);
+                    break;
+            }
+            attacks &= targets & checkMask;
+            if(pinned & bit(from)) attacks &= attackTables.line[kingSq][from];
+            while(attacks) {
+                int to = popLsb(attacks);
+                list.add(Move(from, to, 0));
+            }
         }
+    }
 
-        return minEval;
+    // pawns, set wise. up is the square offset of one step forward
+    Bitboard pawns = pieceBoard(whiteTurn, 6) & fromMask;
+    int up = whiteTurn ? 8 : -8;
+
+    Bitboard single = (whiteTurn ? north(pawns) : south(pawns)) & ~all;
+    Bitboard twice = (whiteTurn ? north(single & rank3) : south(single & rank6)) & ~all & checkMask;
+    single &= checkMask;
+    Bitboard left = (whiteTurn ? northWest(pawns) : southWest(pawns)) & enemy & checkMask;
+    Bitboard right = (whiteTurn ? northEast(pawns) : southEast(pawns)) & enemy & checkMask;
+    if(type == captureMoves) {
+        // pushes only count if they promote
+        single &= rank1 | rank8;
+        twice = 0;
+    } else if(type == quietMoves) {
+        single &= ~(rank1 | rank8);
+        left = right = 0;
     }
-}
 
-// checks if game is over, ends the program when true
-bool BoardState::checkmate() {
-    if(!inCheck(whiteTurn)) return false;
-
-    int x = king[whiteTurn ? 0 : 2];
-    int y = king[whiteTurn ? 1 : 3];
-
-    std::vector< std::pair<int,int> > checks = getChecks(whiteTurn);
-
-    for(Move move: moves) {
-        // check for legal king moves
-        if(move.ox == x && move.oy == y) {
-            if(squares[move.nx][move.ny].id() == 0) {
-                squares[x][y] = Square();
-                king[whiteTurn ? 0 : 2] = move.nx;
-                king[whiteTurn ? 1 : 3] = move.ny;
-                if (!inCheck(whiteTurn)) {
-                    squares[x][y] = Square(whiteTurn, 5);
-                    king[whiteTurn ? 0 : 2] = x;
-                    king[whiteTurn ? 1 : 3] = y;
-                    return false;
-                }
-                squares[x][y] = Square(whiteTurn, 5);
-                king[whiteTurn ? 0 : 2] = x;
-                king[whiteTurn ? 1 : 3] = y;
-            } else if(squares[move.nx][move.ny].isWhite() != whiteTurn) {
-                squares[x][y] = Square();
-                king[whiteTurn ? 0 : 2] = move.nx;
-                king[whiteTurn ? 1 : 3] = move.ny;
-                if (!inCheck(whiteTurn)) {
-                    squares[x][y] = Square(whiteTurn, 5);
-                    king[whiteTurn ? 0 : 2] = x;
-                    king[whiteTurn ? 1 : 3] = y;
-                    return false;
-                }
-                squares[x][y] = Square(whiteTurn, 5);
-                king[whiteTurn ? 0 : 2] = x;
-                king[whiteTurn ? 1 : 3] = y;
-            }
-        }
+    while(single) {
+        int to = popLsb(single);
+        if(allowed(to - up, to)) addPawnMoves(list, to - up, to);
+    }
+    while(twice) {
+        int to = popLsb(twice);
+        if(allowed(to - 2 * up, to)) addPawnMoves(list, to - 2 * up, to);
+    }
+    while(left) {
+        int to = popLsb(left);
+        if(allowed(to - up + 1, to)) addPawnMoves(list, to - up + 1, to);
+    }
+    while(right) {
+        int to = popLsb(right);
+        if(allowed(to - up - 1, to)) addPawnMoves(list, to - up - 1, to);
+    }
 
-        // check for legal blocking moves
-        if(checks.size() == 1) {
-            if(checks[0].first == x && move.nx == x
-            && ((checks[0].second >= move.ny && move.ny > y) || (checks[0].second <= move.ny && move.ny < y))
-            && !movePiece(move).inCheck(whiteTurn)) { // vertical rook checks
-                return false;
-            } else if(checks[0].second == y && move.ny == y
-            && ((checks[0].first >= move.nx && move.nx > x) || (checks[0].first <= move.nx && move.nx < x))
-            && !movePiece(move).inCheck(whiteTurn)) { // horizontal rook checks
-                return false;
-            } else if(abs(checks[0].first - x) == abs(checks[0].second - y) && abs(move.nx - x) == abs(move.ny - y)) { // bishop checks
-                if(((checks[0].second >= move.ny && move.ny > y) || (checks[0].second <= move.ny && move.ny < y))
-                && !movePiece(move).inCheck(whiteTurn)) {
-                    return false;
-                }
-            } else if(move.nx == checks[0].first && move.ny == checks[0].second &&
-            !movePiece(move).inCheck(whiteTurn)) { // knight checks
-                return false;
+    // en passant takes a pawn off a square the capturing pawn doesn't land on, which can uncover the king along a rank
+    // even when neither pawn is pinned on its own. so the king is tested on the board as it will be after the capture
+    if(epSquare >= 0 && type != quietMoves) {
+        int taken = epSquare - up;
+        for(Bitboard b = attackTables.pawn[whiteTurn ? 1 : 0][epSquare] & pawns; b;) {
+            int from = popLsb(b);
+            Bitboard after = (all ^ bit(from) ^ bit(taken)) | bit(epSquare);
+            if(!(attackersTo(kingSq, !whiteTurn, after) & ~bit(taken))) {
+                list.add(Move(from, epSquare, 0));
             }
         }
     }
-    return true;
 }
 
-// generate the list of moves for the board state.
-void BoardState::getMoves() {
-    moves.reserve(100);
-
-    if (canCastle[whiteTurn ? 0 : 2] && squares[1][whiteTurn ? 0 : 8].id() == 0
-    && squares[2][whiteTurn ? 0 : 8].id() == 0) moves.emplace_back("O-O");
-    if (canCastle[whiteTurn ? 1 : 3] && squares[4][whiteTurn ? 0 : 8].id() == 0
-    && squares[5][whiteTurn ? 0 : 8].id() == 0 && squares[6][whiteTurn ? 0 : 8].id() == 0) moves.emplace_back("O-O-O");
+// pieces of the side to move that are the only thing between their king and an enemy slider
+Bitboard BoardState::pinnedPieces(int kingSq) const {
+    Bitboard own = occupied[whiteTurn ? 0 : 1];
+    Bitboard enemy = occupied[whiteTurn ? 1 : 0];
+    Bitboard queens = pieceBoard(!whiteTurn, 4);
+    // enemy sliders that would attack the king if none of our pieces were in the way
+    Bitboard snipers = (attackTables.rook(kingSq, enemy) & (pieceBoard(!whiteTurn, 1) | queens))
+    | (attackTables.bishop(kingSq, enemy) & (pieceBoard(!whiteTurn, 3) | queens));
+
+    Bitboard pinned = 0;
+    while(snipers) {
+        Bitboard blockers = attackTables.between[kingSq][popLsb(snipers)] & (own | enemy);
+        if(popCount(blockers) == 1) pinned |= blockers & own;
+    }
+    return pinned;
+}
 
-    for(int i = 0; i < 8; i++) {
-        for(int j = 0; j < 8; j++) {
-            if(squares[i][j].isWhite() == whiteTurn) {
-                switch (squares[i][j].id()) {
-                    case 1: // rook
-                        // right
-                        for(int k = i + 1; k < 8; k++) {
-                            if(squares[k][j].id() <= 0) {
-                                moves.emplace_back(i,j,k,j,0);
-                            } else {
-                                if(squares[k][j].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,k,j,0);
-                                }
-                                k = 8;
-                            }
-                        }
-                        // left
-                        for(int k = i - 1; k >= 0; k--) {
-                            if(squares[k][j].id() <= 0) {
-                                moves.emplace_back(i,j,k,j,0);
-                            } else {
-                                if(squares[k][j].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,k,j,0);
-                                }
-                                k = -1;
-                            }
-                        }
-                        // up
-                        for(int k = j + 1; k < 8; k++) {
-                            if(squares[i][k].id() <= 0) {
-                                moves.emplace_back(i,j,i,k,0);
-                            } else {
-                                if(squares[i][k].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,i,k,0);
-                                }
-                                k = 8;
-                            }
-                        }
-                        // down
-                        for(int k = j - 1; k >= 0; k--) {
-                            if(squares[i][k].id() <= 0) {
-                                moves.emplace_back(i,j,i,k,0);
-                            } else {
-                                if(squares[i][k].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,i,k,0);
-                                }
-                                k = -1;
-                            }
-                        }
-                        break;
-                    case 2: // knight
-                        if(i < 7 && j < 6 && (squares[i + 1][j + 2].id() <= 0 || squares[i + 1][j + 2].isWhite() != whiteTurn))
-                            moves.emplace_back(i,j,i + 1,j + 2,0);
-                        if(i < 7 && j > 1 && (squares[i + 1][j - 2].id() <= 0 || squares[i + 1][j - 2].isWhite() != whiteTurn))
-                            moves.emplace_back(i,j,i + 1,j - 2,0);
-                        if(i > 0 && j < 6 && (squares[i - 1][j + 2].id() <= 0 || squares[i - 1][j + 2].isWhite() != whiteTurn))
-                            moves.emplace_back(i,j,i - 1,j + 2,0);
-                        if(i > 0 && j > 1 && (squares[i - 1][j - 2].id() <= 0 || squares[i - 1][j - 2].isWhite() != whiteTurn))
-                            moves.emplace_back(i,j,i - 1,j - 2,0);
-                        if(i < 6 && j < 7 && (squares[i + 2][j + 1].id() <= 0 || squares[i + 2][j + 1].isWhite() != whiteTurn))
-                            moves.emplace_back(i,j,i + 2,j + 1,0);
-                        if(i < 6 && j > 0 && (squares[i + 2][j - 1].id() <= 0 || squares[i + 2][j - 1].isWhite() != whiteTurn))
-                            moves.emplace_back(i,j,i + 2,j - 1,0);
-                        if(i > 1 && j < 7 && (squares[i - 2][j + 1].id() <= 0 || squares[i - 2][j + 1].isWhite() != whiteTurn))
-                            moves.emplace_back(i,j,i - 2,j + 1,0);
-                        if(i > 1 && j > 0 && (squares[i - 2][j - 1].id() <= 0 || squares[i - 2][j - 1].isWhite() != whiteTurn))
-                            moves.emplace_back(i,j,i - 2,j - 1,0);
-                        break;
-                    case 3: // bishop
-                        // up right
-                        for(int k = 1; k <= std::min(7 - i, 7 - j); k++) {
-                            if(squares[i + k][j + k].id() <= 0) {
-                                moves.emplace_back(i,j,i + k,j + k,0);
-                            } else {
-                                if(squares[i + k][j + k].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,i + k,j + k,0);
-                                }
-                                break;
-                            }
-                        }
-                        // down right
-                        for(int k = 1; k <= std::min(7 - i, j); k++) {
-                            if(squares[i + k][j - k].id() <= 0) {
-                                moves.emplace_back(i,j,i + k,j - k,0);
-                            } else {
-                                if(squares[i + k][j - k].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,i + k,j - k,0);
-                                }
-                                break;
-                            }
-                        }
-                        // up left
-                        for(int k = 1; k <= std::min(i, 7 - j); k++) {
-                            if(squares[i - k][j + k].id() <= 0) {
-                                moves.emplace_back(i,j,i - k,j + k,0);
-                            } else {
-                                if(squares[i - k][j + k].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,i - k,j + k,0);
-                                }
-                                break;
-                            }
-                        }
-                        // down left
-                        for(int k = 1; k <= std::min(i, j); k++) {
-                            if(squares[i - k][j - k].id() <= 0) {
-                                moves.emplace_back(i,j,i - k,j - k,0);
-                            } else {
-                                if(squares[i - k][j - k].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,i - k,j - k,0);
-                                }
-                                break;
-                            }
-                        }
-                        break;
-                    case 4: // queen
-                        // right
-                        for(int k = i + 1; k < 8; k++) {
-                            if(squares[k][j].id() <= 0) {
-                                moves.emplace_back(i,j,k,j,0);
-                            } else {
-                                if(squares[k][j].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,k,j,0);
-                                }
-                                break;
-                            }
-                        }
-                        // left
-                        for(int k = i - 1; k >= 0; k--) {
-                            if(squares[k][j].id() <= 0) {
-                                moves.emplace_back(i,j,k,j,0);
-                            } else {
-                                if(squares[k][j].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,k,j,0);
-                                }
-                                break;
-                            }
-                        }
-                        // up
-                        for(int k = j + 1; k < 8; k++) {
-                            if(squares[i][k].id() <= 0) {
-                                moves.emplace_back(i,j,i,k,0);
-                            } else {
-                                if(squares[i][k].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,i,k,0);
-                                }
-                                break;
-                            }
-                        }
-                        // up
-                        for(int k = j - 1; k >= 0; k--) {
-                            if(squares[i][k].id() <= 0) {
-                                moves.emplace_back(i,j,i,k,0);
-                            } else {
-                                if(squares[i][k].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,i,k,0);
-                                }
-                                break;
-                            }
-                        }
-                        // up right
-                        for(int k = 1; k <= std::min(7 - i, 7 - j); k++) {
-                            if(squares[i + k][j + k].id() <= 0) {
-                                moves.emplace_back(i,j,i + k,j + k,0);
-                            } else {
-                                if(squares[i + k][j + k].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,i + k,j + k,0);
-                                }
-                                break;
-                            }
-                        }
-                        // down right
-                        for(int k = 1; k <= std::min(7 - i, j); k++) {
-                            if(squares[i + k][j - k].id() <= 0) {
-                                moves.emplace_back(i,j,i + k,j - k,0);
-                            } else {
-                                if(squares[i + k][j - k].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,i + k,j - k,0);
-                                }
-                                break;
-                            }
-                        }
-                        // up left
-                        for(int k = 1; k <= std::min(i, 7 - j); k++) {
-                            if(squares[i - k][j + k].id() <= 0) {
-                                moves.emplace_back(i,j,i - k,j + k,0);
-                            } else {
-                                if(squares[i - k][j + k].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,i - k,j + k,0);
-                                }
-                                break;
-                            }
-                        }
-                        // down left
-                        for(int k = 1; k <= std::min(i, j); k++) {
-                            if(squares[i - k][j - k].id() <= 0) {
-                                moves.emplace_back(i,j,i - k,j - k,0);
-                            } else {
-                                if(squares[i - k][j - k].isWhite() != whiteTurn) {
-                                    moves.emplace_back(i,j,i - k,j - k,0);
-                                }
-                                break;
-                            }
-                        }
-                        break;
-                    case 5: // king
-                        if(i < 7 && (squares[i + 1][j].id() <= 0 || squares[i + 1][j].isWhite() != whiteTurn)
-                        && !(abs(i + 1 - king[whiteTurn ? 2 : 0]) <= 1 && abs(j - king[whiteTurn ? 3 : 1]) <= 1))
-                            moves.emplace_back(i,j,i + 1,j,0);
-                        if(i < 7 && j < 7 && (squares[i + 1][j + 1].id() <= 0 || squares[i + 1][j + 1].isWhite() != whiteTurn)
-                        && !(abs(i + 1 - king[whiteTurn ? 2 : 0]) <= 1 && abs(j + 1 - king[whiteTurn ? 3 : 1]) <= 1))
-                            moves.emplace_back(i,j,i + 1,j + 1,0);
-                        if(j < 7 && (squares[i][j + 1].id() <= 0 || squares[i][j + 1].isWhite() != whiteTurn)
-                        && !(abs(i - king[whiteTurn ? 2 : 0]) <= 1 && abs(j + 1 - king[whiteTurn ? 3 : 1]) <= 1))
-                            moves.emplace_back(i,j,i,j + 1,0);
-                        if(i > 0 && j < 7 && (squares[i - 1][j + 1].id() <= 0 || squares[i - 1][j + 1].isWhite() != whiteTurn)
-                        && !(abs(i - 1 - king[whiteTurn ? 2 : 0]) <= 1 && abs(j + 1 - king[whiteTurn ? 3 : 1]) <= 1))
-                            moves.emplace_back(i,j,i - 1,j + 1,0);
-                        if(i > 0 && (squares[i - 1][j].id() <= 0 || squares[i - 1][j].isWhite() != whiteTurn)
-                        && !(abs(i - 1 - king[whiteTurn ? 2 : 0]) <= 1 && abs(j - king[whiteTurn ? 3 : 1]) <= 1))
-                            moves.emplace_back(i,j,i - 1,j,0);
-                        if(i > 0 && j > 0 && (squares[i - 1][j - 1].id() <= 0 || squares[i - 1][j - 1].isWhite() != whiteTurn)
-                        && !(abs(i - 1 - king[whiteTurn ? 2 : 0]) <= 1 && abs(j - 1 - king[whiteTurn ? 3 : 1]) <= 1))
-                            moves.emplace_back(i,j,i - 1,j - 1,0);
-                        if(j > 0 && (squares[i][j - 1].id() <= 0 || squares[i][j - 1].isWhite() != whiteTurn)
-                        && !(abs(i - king[whiteTurn ? 2 : 0]) <= 1 && abs(j - 1 - king[whiteTurn ? 3 : 1]) <= 1))
-                            moves.emplace_back(i,j,i,j - 1,0);
-                        if(i < 7 && j > 0 && (squares[i + 1][j - 1].id() <= 0 || squares[i + 1][j - 1].isWhite() != whiteTurn)
-                        && !(abs(i + 1 - king[whiteTurn ? 2 : 0]) <= 1 && abs(j - 1 - king[whiteTurn ? 3 : 1]) <= 1))
-                            moves.emplace_back(i,j,i + 1,j - 1,0);
-                        break;
-                    case 6: // pawn
-                        if(squares[i][j + (whiteTurn ? 1: -1)].id() == 0) {
-                            // double move
-                            if(j == (whiteTurn ? 1 : 6) && squares[i][j + (whiteTurn ? 1: -1)].id() == 0
-                            && squares[i][j + (whiteTurn ? 2: -2)].id() == 0) {
-                                moves.emplace_back(i,j,i,j + (whiteTurn ? 2 : -2), 0);
-                            }
-                            // normal move
-                            if(j == (whiteTurn ? 6 : 1)) {
-                                moves.emplace_back(i,j,i,j + (whiteTurn ? 1 : -1), 'Q');
-                                moves.emplace_back(i,j,i,j + (whiteTurn ? 1 : -1), 'N');
-                                moves.emplace_back(i,j,i,j + (whiteTurn ? 1 : -1), 'B');
-                                moves.emplace_back(i,j,i,j + (whiteTurn ? 1 : -1), 'R');
-                            } else {
-                                moves.emplace_back(i,j,i,j + (whiteTurn ? 1 : -1), 0);
-                            }
-                        }
-                        // capture right
-                        if(i < 7 && squares[i + 1][j + (whiteTurn ? 1 : -1)].id() != 0
-                           && squares[i + 1][j + (whiteTurn ? 1 : -1)].isWhite() != whiteTurn) {
-                            if(j == (whiteTurn ? 6 : 1)) {
-                                moves.emplace_back(i,j,i + 1,j + (whiteTurn ? 1 : -1), 'Q');
-                                moves.emplace_back(i,j,i + 1,j + (whiteTurn ? 1 : -1), 'N');
-                                moves.emplace_back(i,j,i + 1,j + (whiteTurn ? 1 : -1), 'B');
-                                moves.emplace_back(i,j,i + 1,j + (whiteTurn ? 1 : -1), 'R');
-                            } else {
-                                moves.emplace_back(i,j,i + 1,j + (whiteTurn ? 1 : -1), 0);
-                            }
-                        }
-                        // capture left
-                        if(i > 0 && squares[i - 1][j + (whiteTurn ? 1 : -1)].id() != 0
-                           && squares[i - 1][j + (whiteTurn ? 1 : -1)].isWhite() != whiteTurn) {
-                            if(j == (whiteTurn ? 6 : 1)) {
-                                moves.emplace_back(i,j,i - 1,j + (whiteTurn ? 1 : -1), 'Q');
-                                moves.emplace_back(i,j,i - 1,j + (whiteTurn ? 1 : -1), 'N');
-                                moves.emplace_back(i,j,i - 1,j + (whiteTurn ? 1 : -1), 'B');
-                                moves.emplace_back(i,j,i - 1,j + (whiteTurn ? 1 : -1), 'R');
-                            } else {
-                                moves.emplace_back(i,j,i - 1,j + (whiteTurn ? 1 : -1), 0);
-                            }
-                        }
-                        break;
-                }
-            }
-        }
+// adds a pawn move, or all four promotions if the pawn reaches the last rank
+void BoardState::addPawnMoves(MoveList &list, int from, int to) {
+    if(to >= 56 || to < 8) {
+        // queen, knight, bishop, rook
+        for(int special : {6, 4, 5, 3}) list.add(Move(from, to, special));
+    } else {
+        list.add(Move(from, to, 0));
     }
 }
 
 // prints out all possible moves
 std::string BoardState::printMoves() {
+    MoveList moves;
+    generateMoves(moves);
     std::string str = "\n";
     for(auto move : moves) {
-        str += squares[move.ox][move.oy].toUni() + ": ";
-        str.push_back('0' + move.ox);
+        str += getSquare(move.ox(), move.oy()).toUni() + ": ";
+        str.push_back('0' + move.ox());
         str += " ";
-        str.push_back('0' + move.oy);
+        str.push_back('0' + move.oy());
         str += " -> ";
-        str.push_back('0' + move.nx);
+        str.push_back('0' + move.nx());
         str += " ";
-        str.push_back('0' + move.ny);
+        str.push_back('0' + move.ny());
         str += "\n";
     }
 
@@ -1067,93 +1084,56 @@ std::string BoardState::printMoves() {
     return str;
 }
 
-// returns list of squares on the board responsible for checking the king
-std::vector< std::pair<int,int> > BoardState::getChecks(bool white) {
-    std::vector< std::pair<int,int> > checks;
-    int x = king[(white ? 0 : 2)];
-    int y = king[(white ? 1 : 3)];
-
-    // check up
-    for(int i = y; i < 8; i++) {
-        if(i != y) {
-            if((squares[x][i].isWhite() == white || (squares[x][i].id() != 1 && squares[x][i].id() != 4)) && squares[x][i].id() > 0) break;
-            if ((squares[x][i].id() == 1 || squares[x][i].id() == 4)
-                && squares[x][i].isWhite() == !white) checks.emplace_back(x,i);
-        }
-    }
-    // check down
-    for(int i = y; i >= 0; i--) {
-        if(i != y) {
-            if((squares[x][i].isWhite() == white || (squares[x][i].id() != 1 && squares[x][i].id() != 4)) && squares[x][i].id() > 0) break;
-            if ((squares[x][i].id() == 1 || squares[x][i].id() == 4)
-                && squares[x][i].isWhite() == !white) checks.emplace_back(x,i);
-        }
+// long algebraic notation of a move, like e2e4 or e7e8q. castles are written as the king's move
+std::string BoardState::moveString(Move move) const {
+    if(move.special() == -1) return "0000";
+    if(move.special() == 1 || move.special() == 2) {
+        std::string rank(1, whiteTurn ? '1' : '8');
+        return "e" + rank + (move.special() == 1 ? "g" : "c") + rank;
     }
-    // check right
-    for(int i = x; i < 8; i++) {
-        if(i != x) {
-            if((squares[i][y].isWhite() == white || (squares[i][y].id() != 1 && squares[i][y].id() != 4)) && squares[i][y].id() > 0) break;
-            if ((squares[i][y].id() == 1 || squares[i][y].id() == 4)
-                && squares[i][y].isWhite() == !white) checks.emplace_back(i,y);
-        }
-    }
-    // check left
-    for(int i = x; i >= 0; i--) {
-        if(i != x) {
-            if((squares[i][y].isWhite() == white  || (squares[i][y].id() != 1 && squares[i][y].id() != 4)) && squares[i][y].id() > 0) break;
-            if ((squares[i][y].id() == 1 || squares[i][y].id() == 4)
-                && squares[i][y].isWhite() == !white) checks.emplace_back(i,y);
-        }
-    }
-    // check up right
-    for(int i = 1; i < 8; i++) {
-        if(i + y > 7 || i + x > 7) break;
-        if((squares[i + x][i + y].isWhite() == white || (squares[x + i][y + i].id() != 3 && squares[x + i][y + i].id() != 4))
-           && squares[i + x][i + y].id() > 0) break;
-        if ((squares[i + x][i + y].id() == 3 || squares[i + x][i + y].id() == 4)
-            && squares[i + x][i + y].isWhite() == !white) checks.emplace_back(i + x,i + y);
-    }
-    // check down right
-    for(int i = 1; i < 8; i++) {
-        if(y - i < 0 || i + x > 7) break;
-        if((squares[x + i][y - i].isWhite() == white || (squares[x + i][y - i].id() != 3 && squares[x + i][y - i].id() != 4))
-           && squares[x + i][y - i].id() > 0) break;
-        if ((squares[x + i][y - i].id() == 3 || squares[x + i][y - i].id() == 4)
-            && squares[x + i][y - i].isWhite() == !white) checks.emplace_back(x + i,y - i);
+
+    std::string str;
+    str.push_back(char('a' + move.ox()));
+    str.push_back(char('1' + move.oy()));
+    str.push_back(char('a' + move.nx()));
+    str.push_back(char('1' + move.ny()));
+    if(move.special() > 2) str.push_back(" rnbq"[move.special() - 2]);
+    return str;
+}
+
+// a line of moves played from this position, each in long algebraic notation. every move is written on the board it
+// is played on, because castles depend on the side to move
+std::vector<std::string> BoardState::lineStrings(const std::vector<Move> &line) const {
+    std::vector<std::string> strings;
+    BoardState board = *this;
+    for(Move move : line) {
+        strings.push_back(board.moveString(move));
+        board.makeMove(move);
     }
-    // check up left
-    for(int i = 1; i < 8; i++) {
-        if(y + i > 7 || x - i < 0) break;
-        if((squares[x - i][y + i].isWhite() == white || (squares[x - i][y + i].id() != 3 && squares[x - i][y + i].id() != 4))
-           && squares[x - i][y + i].id() > 0) break;
-        if ((squares[x - i][y + i].id() == 3 || squares[x - i][y + i].id() == 4)
-            && squares[x - i][y + i].isWhite() == !white) checks.emplace_back(x - i,y + i);
+    return strings;
+}
+
+// reads a move in long algebraic notation. returns the illegal move (special = -1) if it isn't a legal move here
+Move BoardState::moveFromString(std::string_view text) {
+    MoveList list;
+    generateMoves(list);
+    for(Move move : list) {
+        if(moveString(move) == text) return move;
     }
-    // check down left
-    for(int i = 1; i < 8; i++) {
-        if(y - i < 0 || x - i < 0) break;
-        if ((squares[x - i][y - i].isWhite() == white ||
-             (squares[x - i][y - i].id() != 3 && squares[x - i][y - i].id() != 4))
-            && squares[x - i][y - i].id() > 0) break;
-        if ((squares[x - i][y - i].id() == 3 || squares[x - i][y - i].id() == 4)
-            && squares[x - i][y - i].isWhite() == !white) checks.emplace_back(x - i,y - i);
+    return noMove;
+}
+
+// returns list of squares on the board responsible for checking the king
+std::vector< std::pair<int,int> > BoardState::getChecks(bool white) {
+    std::vector< std::pair<int,int> > checks;
+    Bitboard attackers = attackersTo(square(king[white ? 0 : 2], king[white ? 1 : 3]), !white);
+
+    while(attackers) {
+        int sq = popLsb(attackers);
+        checks.emplace_back(sq % 8, sq / 8);
     }
-    // check for knight attacks
-    if(x < 7 && y < 6 && squares[x + 1][y + 2].id() == 2 && squares[x + 1][y + 2].isWhite() == !white) checks.emplace_back(x + 1,y + 2);
-    if(x > 0 && y < 6 && squares[x - 1][y + 2].id() == 2 && squares[x - 1][y + 2].isWhite() == !white) checks.emplace_back(x - 1,y + 2);
-    if(x < 7 && y > 1 && squares[x + 1][y - 2].id() == 2 && squares[x + 1][y - 2].isWhite() == !white) checks.emplace_back(x + 1,y - 2);
-    if(x > 0 && y > 1 && squares[x - 1][y - 2].id() == 2 && squares[x - 1][y - 2].isWhite() == !white) checks.emplace_back(x - 1,y - 2);
-    if(x < 6 && y < 7 && squares[x + 2][y + 1].id() == 2 && squares[x + 2][y + 1].isWhite() == !white) checks.emplace_back(x + 2,y + 1);
-    if(x > 1 && y < 7 && squares[x - 2][y + 1].id() == 2 && squares[x - 2][y + 1].isWhite() == !white) checks.emplace_back(x - 2,y + 1);
-    if(x < 6 && y > 0 && squares[x + 2][y - 1].id() == 2 && squares[x + 2][y - 1].isWhite() == !white) checks.emplace_back(x + 2,y - 1);
-    if(x > 1 && y > 0 && squares[x - 2][y - 1].id() == 2 && squares[x - 2][y - 1].isWhite() == !white) checks.emplace_back(x - 2,y - 1);
-    //check for pawn attacks
-    if(squares[x + 1][y + (white ? 1 : -1)].isWhite() == !white
-       && squares[x + 1][y + (white ? 1 : -1)].id() == 6) checks.emplace_back(x + 1,y + (white ? 1 : -1));
-    if(squares[x - 1][y + (white ? 1 : -1)].isWhite() == !white
-       && squares[x - 1][y + (white ? 1 : -1)].id() == 6) checks.emplace_back(x - 1,y + (white ? 1 : -1));
 
     return checks;
 }
 
-#pragma clang diagnostic pop
\ No newline at end of file
+#pragma clang diagnostic pop
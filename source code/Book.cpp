@@ -0,0 +1,129 @@
+#pragma once
+#include "BoardState.cpp"
+#include "MappedFile.cpp"
+#include <random>
+
+//
+// Opening book in Polyglot's .bin format, so the first moves of a game come from theory instead of a search. The file
+// is memory mapped and never read as a whole: a lookup binary searches the sorted entries and only touches the pages
+// it lands on, so opening a book of any size is instant. Positions are looked up by BoardState::polyglotKey.
+//
+
+class Book {
+public:
+    Book();
+    ~Book();
+    Book(const Book &) = delete;
+    Book &operator = (const Book &) = delete;
+    void open(const std::string &path);
+    void close();
+    bool isOpen() const;
+    Move probe(BoardState &board);
+
+private:
+    // entries are 16 bytes, big endian: key, move, weight, then 4 bytes the engine doesn't use
+    const static size_t entrySize = 16;
+    const unsigned char *data;
+    size_t size; // bytes mapped
+    size_t count; // entries
+    std::mt19937_64 random;
+
+    uint64_t keyAt(size_t i) const;
+    static uint64_t readBig(const unsigned char *bytes, int length);
+    static Move decode(BoardState &board, unsigned move);
+};
+
+Book::Book() : data(nullptr), size(0), count(0), random(std::random_device()()) {}
+
+Book::~Book() {
+    close();
+}
+
+// maps a book file. throws std::runtime_error if it can't be mapped or isn't a whole number of entries
+void Book::open(const std::string &path) {
+    close();
+    size_t length = 0;
+    const uint8_t *mapped = mapReadOnly(path, length);
+    if(mapped == nullptr) throw std::runtime_error("can't open book " + path);
+    if(length % entrySize != 0) {
+        unmapReadOnly(mapped, length);
+        throw std::runtime_error(path + " is not a Polyglot book");
+    }
+    data = mapped;
+    size = length;
+    count = size / entrySize;
+}
+
+void Book::close() {
+    unmapReadOnly(data, size);
+    data = nullptr;
+    size = 0;
+    count = 0;
+}
+
+// true while a book is mapped
+bool Book::isOpen() const {
+    return data != nullptr;
+}
+
+// picks one of the book moves of the position at random, moves with more weight more often. returns the illegal move
+// (special = -1) if the position isn't in the book
+Move Book::probe(BoardState &board) {
+    if(!isOpen()) return noMove;
+    uint64_t key = board.polyglotKey();
+
+    // first entry with the key, entries are sorted by key
+    size_t low = 0, high = count;
+    while(low < high) {
+        size_t middle = low + (high - low) / 2;
+        if(keyAt(middle) < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    uint64_t total = 0;
+    size_t end = low;
+    for(; end < count && keyAt(end) == key; end++) total += readBig(data + end * entrySize + 10, 2);
+    if(end == low) return noMove;
+
+    // with every weight 0 the moves are equally likely
+    uint64_t pick = std::uniform_int_distribution<uint64_t>(0, (total == 0 ? end - low : total) - 1)(random);
+    for(size_t i = low; i < end; i++) {
+        const unsigned char *entry = data + i * entrySize;
+        uint64_t weight = total == 0 ? 1 : readBig(entry + 10, 2);
+        if(pick < weight) return decode(board, unsigned(readBig(entry + 8, 2)));
+        pick -= weight;
+    }
+    return noMove;
+}
+
+uint64_t Book::keyAt(size_t i) const {
+    return readBig(data + i * entrySize, 8);
+}
+
+uint64_t Book::readBig(const unsigned char *bytes, int length) {
+    uint64_t value = 0;
+    for(int i = 0; i < length; i++) value = value << 8 | bytes[i];
+    return value;
+}
+
+// turns a Polyglot move into one of ours: to square in bits 0-5, from square in bits 6-11, promotion in bits 12-14
+// (knight, bishop, rook, queen from 1). castles are written as the king taking its own rook. a move that isn't legal
+// here, which a bad book or a key collision can give, comes back as the illegal move
+Move Book::decode(BoardState &board, unsigned move) {
+    int to = move & 63;
+    int from = (move >> 6) & 63;
+    int promotion = (move >> 12) & 7;
+
+    Move result;
+    if(board.pieceAt(from) == 5 && from % 8 == 4 && (to == from + 3 || to == from - 4)) {
+        result = Move(to > from ? "O-O" : "O-O-O");
+    } else {
+        // our promotion codes are 3 rook, 4 knight, 5 bishop, 6 queen
+        const int special [5] = {0, 4, 5, 3, 6};
+        result = Move(from, to, promotion <= 4 ? special[promotion] : 0);
+    }
+    return board.legalMove(result) ? result : noMove;
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include "Uci.cpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//
+// Checks of behaviour that perft can't see, each a small scenario run against the public interface. Every check
+// prints its name and whether it passed.
+//
+
+class Check {
+public:
+    static bool run();
+
+private:
+    struct Case {
+        const char *name;
+        bool (*check)();
+    };
+    const static Case cases [];
+
+    static bool networkEvalBounded();
+    static void writeNetwork(const std::string &path, int8_t outputWeight);
+    static bool goPonderAnswers();
+    static bool uciAnswers(const std::vector<std::string> &commands, const std::string &expected, int timeoutMS);
+};
+
+const Check::Case Check::cases [] = {
+    {"network eval stays below tablebase scores", networkEvalBounded},
+    {"go ponder movetime answers without stop", goPonderAnswers},
+};
+
+// runs every check. returns true if all of them passed
+bool Check::run() {
+    bool passed = true;
+    for(const Case &test : cases) {
+        bool ok = test.check();
+        passed = passed && ok;
+        std::cout << std::left << std::setw(50) << test.name << (ok ? "ok" : "FAILED") << "\n";
+    }
+    std::cout << (passed ? "all checks passed" : "some checks FAILED") << "\n";
+    return passed;
+}
+
+// a network whose output is far beyond any real score, both ways, must still eval inside the centipawn range
+bool Check::networkEvalBounded() {
+    const char *fens [] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+    std::string path = (std::filesystem::temp_directory_path() / "check.nnue").string();
+    bool passed = true;
+    for(int8_t weight : {int8_t(127), int8_t(-128)}) {
+        writeNetwork(path, weight);
+        Network::load(path);
+        for(const char *fen : fens) {
+            BoardState board = BoardState::fromFEN(fen);
+            passed = passed && std::abs(board.eval()) == maxEvalScore;
+        }
+    }
+    Network::unload();
+    std::remove(path.c_str());
+    return passed;
+}
+
+// writes a network that saturates every hidden value, so its output is 32 * 127 * 127 * outputWeight / 16 and more
+void Check::writeNetwork(const std::string &path, int8_t outputWeight) {
+    std::ofstream file(path, std::ios::binary);
+    auto write = [&file](const void *data, size_t bytes) {
+        file.write(static_cast<const char *>(data), std::streamsize(bytes));
+    };
+    uint32_t sizes [4] = {Network::features, Network::hidden, Network::layer1, Network::layer2};
+    write("CENNUE01", 8);
+    write(sizes, sizeof(sizes));
+    std::vector<int16_t> featureBias(Network::hidden, 127);
+    write(featureBias.data(), featureBias.size() * sizeof(int16_t));
+    std::vector<int16_t> featureWeights(size_t(Network::features) * Network::hidden, 0);
+    write(featureWeights.data(), featureWeights.size() * sizeof(int16_t));
+    std::vector<int32_t> layerBias(Network::layer1, 1 << 20);
+    std::vector<int8_t> layer1Weights(size_t(Network::layer1) * 2 * Network::hidden, 0);
+    write(layerBias.data(), layerBias.size() * sizeof(int32_t));
+    write(layer1Weights.data(), layer1Weights.size());
+    std::vector<int8_t> layer2Weights(size_t(Network::layer2) * Network::layer1, 0);
+    write(layerBias.data(), layerBias.size() * sizeof(int32_t));
+    write(layer2Weights.data(), layer2Weights.size());
+    int32_t outputBias = 0;
+    std::vector<int8_t> outputWeights(Network::layer2, outputWeight);
+    write(&outputBias, sizeof(outputBias));
+    write(outputWeights.data(), outputWeights.size());
+}
+
+// limits after a token that takes no value, like ponder, must still count: the search ends at movetime by itself
+bool Check::goPonderAnswers() {
+    return uciAnswers({"position startpos", "go ponder movetime 100"}, "bestmove", 5000);
+}
+
+// runs a UCI session in a child process, as a GUI would talk to the engine over pipes, and waits for a line starting
+// with expected. input stays open meanwhile, so nothing stops the search but the engine itself. returns false if the
+// line doesn't come within timeoutMS
+bool Check::uciAnswers(const std::vector<std::string> &commands, const std::string &expected, int timeoutMS) {
+    int input [2], output [2];
+    if(pipe(input) != 0 || pipe(output) != 0) return false;
+    std::cout.flush();
+    pid_t child = fork();
+    if(child < 0) return false;
+    if(child == 0) {
+        dup2(input[0], STDIN_FILENO);
+        dup2(output[1], STDOUT_FILENO);
+        close(input[1]);
+        close(output[0]);
+        Uci uci;
+        uci.loop();
+        std::cout.flush();
+        _exit(0);
+    }
+    close(input[0]);
+    close(output[1]);
+
+    std::string text;
+    for(const std::string &command : commands) text += command + "\n";
+    bool found = false;
+    bool sent = write(input[1], text.data(), text.size()) == ssize_t(text.size());
+
+    // reads lines until the expected one, the end of output or the time runs out
+    std::string lines;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMS);
+    while(sent && !found) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        pollfd ready{output[0], POLLIN, 0};
+        if(left.count() <= 0 || poll(&ready, 1, int(left.count())) <= 0) break;
+        char buffer [4096];
+        ssize_t bytes = read(output[0], buffer, sizeof(buffer));
+        if(bytes <= 0) break;
+        lines.append(buffer, size_t(bytes));
+        found = lines.compare(0, expected.size(), expected) == 0 || lines.find("\n" + expected) != std::string::npos;
+    }
+
+    const char quit [] = "quit\n";
+    if(write(input[1], quit, sizeof(quit) - 1) < 0) found = false;
+    close(input[1]);
+    close(output[0]);
+    waitpid(child, nullptr, 0);
+    return found;
+}
@@ -1,4 +1,7 @@
-#include "BoardState.cpp"
+#pragma once
+#include "Search.cpp"
+#include "Uci.cpp"
+#include <algorithm>
 
 //
 // Contains the active board state and allows for player input to make moves on that board
@@ -7,23 +10,55 @@
 class Game {
 public:
     Game();
+    void useBook(const std::string &path);
     Move getMove(std::string input);
     void play();
 private:
     BoardState current;
+    KeyHistory history; // positions played before current
+    TranspositionTable table;
+    Search search;
+    Book book;
     void turn();
+
+    // how long the engine thinks about each move
+    const static int moveTimeMS = 2000;
+    const static int hashSizeMB = 16;
 };
 
-Game::Game() {
+const int Game::moveTimeMS;
+
+Game::Game() : table(hashSizeMB), search(table) {
     current = BoardState();
+    search.setThreads(int(std::thread::hardware_concurrency()));
+}
+
+// plays book moves for "best" while the position is in the book. throws std::runtime_error if the book can't be
+// mapped
+void Game::useBook(const std::string &path) {
+    book.open(path);
 }
 
 void Game::play() {
 
     std::cout << "\nWelcome! Use algebraic notation to make a move or type \"best\" to let the algorithm move.";
 
-    std::cout << "\n" << current.display() << current.eval() << "\n";
+    std::cout << "\n" << current.display() << current.eval() / 100.0 << "\n";
     while(!current.checkmate()) {
+        if(history.isRepetition(current, 2)) {
+            std::cout << "Draw by threefold repetition.";
+            return;
+        }
+        if(current.fiftyMoveDraw()) {
+            std::cout << "Draw by the fifty move rule.";
+            return;
+        }
+        MoveList moves;
+        current.generateMoves(moves);
+        if(moves.empty()) {
+            std::cout << "Draw by stalemate.";
+            return;
+        }
         turn();
     }
 
@@ -36,43 +71,59 @@ void Game::turn() {
     std::string input;
     std::cin >> input;
 
+    // a chess GUI opens with "uci", the rest of the input is UCI commands
+    if(input == "uci") {
+        Uci uci;
+        uci.command(input);
+        uci.loop();
+        std::exit(0);
+    }
+
     Move move = getMove(input);
 
     std::string bmove;
 
     if(input != "best") {
-        while(move.special == -1) {
+        while(move.special() == -1) {
             std::cout << "Please give legal move: ";
             std::cin >> input;
             move = getMove(input);
         }
     } else {
 
-        bmove.push_back('a' + move.ox);
-        bmove.push_back('1' + move.oy);
+        bmove.push_back('a' + move.ox());
+        bmove.push_back('1' + move.oy());
         bmove += " -> ";
-        bmove.push_back('a' + move.nx);
-        bmove.push_back('1' + move.ny);
+        bmove.push_back('a' + move.nx());
+        bmove.push_back('1' + move.ny());
         std::cout << "\nBest: " + bmove + "\n";
     }
 
+    history.push(current.getHash());
     current = current.movePiece(move);
 
-    std::cout << "\n" << current.display() << current.eval() << "\n";
+    std::cout << "\n" << current.display() << current.eval() / 100.0 << "\n";
     if(bmove.empty()) std::cout << "\nBest: " + bmove + "\n";
 
 }
 
 // takes string input of algebraic chess move format, returns Move. If move is illegal or
-// the string doesn't translate to a valid move, it returns the default move with special = -1 so Game::turn can ask
+// the string doesn't translate to a valid move, it returns noMove, special = -1, so Game::turn can ask
 // for another input.
 Move Game::getMove(std::string input) {
     if (input == "best") {
-        return current.bestMove();
+        Move bookMove = book.probe(current);
+        if(bookMove.special() != -1) {
+            std::cout << "\nbook move\n";
+            return bookMove;
+        }
+        Move best = search.bestMove(current, history, std::chrono::milliseconds(moveTimeMS));
+        std::cout << "\ndepth " << search.depthReached() << " " << search.stats().summary() << "\n";
+        return best;
     }
     if(input == "print") {
         std::cout << current.printMoves();
-        return {};
+        return noMove;
     }
 
     input.erase(remove(input.begin(), input.end(), 'x'), input.end());
@@ -82,12 +133,12 @@ Move Game::getMove(std::string input) {
     input.erase(remove(input.begin(), input.end(), '?'), input.end());
     input.erase(remove(input.begin(), input.end(), '!'), input.end());
 
-    if(input.length() < 2) return {};
+    if(input.length() < 2) return noMove;
 
     if(input == "O-O" || input == "O-O-O") {
         if (current.legalMove(Move(input))) {
             return {input};
-        } else { return {}; }
+        } else { return noMove; }
     }
 
     int id;
@@ -118,7 +169,7 @@ Move Game::getMove(std::string input) {
                 id = 5;
                 break;
             default:
-                return {};
+                return noMove;
         }
         i++;
     } else {
@@ -127,7 +178,7 @@ Move Game::getMove(std::string input) {
 
 
 
-    if (input.length() - i < 2) return {};
+    if (input.length() - i < 2) return noMove;
 
     if(input[i] >= '1' && input[i] <= '8') {
         oy = input[i] - '1';
@@ -139,7 +190,7 @@ Move Game::getMove(std::string input) {
                 if(input[i] >= '1' && input[i] <= '8') {
                     ny = input[i] - '1';
                 } else {
-                    return {};
+                    return noMove;
                 }
             }
         }
@@ -156,14 +207,14 @@ Move Game::getMove(std::string input) {
                 if(input[i] >= '1' && input[i] <= '8') {
                     ny = input[i] - '1';
                 } else {
-                    return {};
+                    return noMove;
                 }
             }
         } else {
-            return {};
+            return noMove;
         }
     } else {
-        return {};
+        return noMove;
     }
 
     // set default prom
@@ -187,7 +238,7 @@ Move Game::getMove(std::string input) {
         }
     }
 
-    if(ox == -1 || oy == -1) return {};
+    if(ox == -1 || oy == -1) return noMove;
 
 
 
@@ -0,0 +1,49 @@
+#pragma once
+#include "BoardState.cpp"
+#include <algorithm>
+
+//
+// Hashes of the positions played before the current one, for finding repetitions. It lives beside the board rather
+// than in it, so copying a board stays cheap: the game and the UCI front end keep one for the moves played so far, and
+// every search thread starts from a copy of it and pushes and pops along the line it searches.
+//
+// Only the last capacity positions are kept. A repetition can't reach further back than the last capture or pawn move,
+// and with the fifty move rule that is at most 100 plies.
+//
+
+class KeyHistory {
+public:
+    void clear();
+    void push(uint64_t key);
+    void pop();
+    bool isRepetition(const BoardState &board, int times = 1) const;
+
+private:
+    const static int capacity = 1024; // a power of two
+    uint64_t keys [capacity];
+    int count = 0; // keys pushed and not popped, the last capacity of them are in keys
+};
+
+void KeyHistory::clear() {
+    count = 0;
+}
+
+// adds the hash of the position a move is about to be played from
+inline void KeyHistory::push(uint64_t key) {
+    keys[count++ & (capacity - 1)] = key;
+}
+
+// takes back the last push, when the move is unmade
+inline void KeyHistory::pop() {
+    count--;
+}
+
+// true if the board's position has been played before, at least times times. only positions since the last capture,
+// pawn move or null move can be the same, and of those only every other one, with the same side to move
+inline bool KeyHistory::isRepetition(const BoardState &board, int times) const {
+    int plies = std::min({board.getRepetitionPlies(), count, capacity});
+    for(int i = 4; i <= plies; i += 2) {
+        if(keys[(count - i) & (capacity - 1)] == board.getHash() && --times == 0) return true;
+    }
+    return false;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//
+// Read only memory mapping of a whole file, for the opening book and the endgame tablebases. Both are looked up at
+// scattered places rather than read through, so only the pages a lookup touches are ever loaded and the kernel is told
+// not to read ahead.
+//
+
+// maps the file at path and sets size to its length in bytes. returns nullptr if the file can't be opened or mapped or
+// is empty
+inline const uint8_t *mapReadOnly(const std::string &path, size_t &size) {
+    int file = ::open(path.c_str(), O_RDONLY);
+    if(file < 0) return nullptr;
+    struct stat info{};
+    if(fstat(file, &info) != 0 || info.st_size == 0) {
+        ::close(file);
+        return nullptr;
+    }
+    void *mapped = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    // the mapping keeps the file open by itself
+    ::close(file);
+    if(mapped == MAP_FAILED) return nullptr;
+    madvise(mapped, size_t(info.st_size), MADV_RANDOM);
+    size = size_t(info.st_size);
+    return static_cast<const uint8_t *>(mapped);
+}
+
+// unmaps what mapReadOnly mapped. does nothing for nullptr
+inline void unmapReadOnly(const uint8_t *address, size_t size) {
+    if(address != nullptr) munmap(const_cast<uint8_t *>(address), size);
+}
@@ -1,31 +1,34 @@
+#pragma once
 #include <iostream>
+#include <cstdint>
+#include <string>
 
-// contains start and end point data as well as info for special moves
+// start and end point data as well as info for special moves, packed into 16 bits: the from square in bits 0-5, the
+// to square in bits 6-11 and the special flag in bits 12-15. special can signify castles (1 short, 2 long, squares
+// unused), pawn promotions (3 rook, 4 knight, 5 bishop, 6 queen) and illegal moves (-1, all bits 0). a default
+// constructed move is left uninitialized like an int, so move lists cost nothing to create. noMove is the illegal move
 struct Move {
-    int ox;
-    int oy;
-    int nx;
-    int ny;
-    int special; // this variable can signify castles, pawn promotions, and illegal moves
-    void init();
-    Move();
+    uint16_t data;
+
+    Move() = default;
     Move(std::string s);
     Move(int oX, int oY, int nX, int nY, char promote);
-
+    Move(int from, int to, int special);
+    explicit Move(uint16_t packed);
+    int from() const;
+    int to() const;
+    int ox() const;
+    int oy() const;
+    int nx() const;
+    int ny() const;
+    int special() const;
+    bool operator == (const Move &other) const;
+    uint16_t pack() const;
 };
 
-// default constructor is for illegal moves. useful for the Game::getMove method as it allows it to return a valid move
-// or just call the default constructor if the move is invalid.
-Move::Move() {
-    init();
-    special = -1;
-}
-// main move constructor used. promote signifies a pawn promotion
+// move constructor used for player input. promote signifies a pawn promotion
 Move::Move(int oX, int oY, int nX, int nY, char promote) {
-    ox = oX;
-    oy = oY;
-    nx = nX;
-    ny = nY;
+    int special;
     switch (promote) {
         default:
             special = 0;
@@ -43,29 +46,123 @@ Move::Move(int oX, int oY, int nX, int nY, char promote) {
             special = 6;
             break;
     }
+    data = uint16_t((oX + 8 * oY) | (nX + 8 * nY) << 6 | special << 12);
+}
+
+// move constructor used by the move generator
+Move::Move(int from, int to, int special) {
+    data = uint16_t(from | to << 6 | special << 12);
 }
 
 // castle
 Move::Move(std::string s) {
-    init();
+    data = 0;
     if(s == "O-O") {
-        special = 1;
+        data = 1 << 12;
     } else if(s == "O-O-O") {
-        special = 2;
+        data = 2 << 12;
     }
 }
 
-// constructor delegation
-void Move::init() {
-    ox = 0;
-    oy = 0;
-    nx = 0;
-    ny = 0;
+// unpacks a move stored with pack. 0 is the illegal move
+Move::Move(uint16_t packed) {
+    data = packed;
+}
+
+// the illegal move (special = -1). stands for no move: the end of a picker's moves, a table entry without a best move
+// or input that isn't a legal move
+const Move noMove(uint16_t(0));
+
+inline int Move::from() const {
+    return data & 63;
+}
+
+inline int Move::to() const {
+    return (data >> 6) & 63;
 }
 
+inline int Move::ox() const {
+    return data & 7;
+}
+
+inline int Move::oy() const {
+    return (data >> 3) & 7;
+}
+
+inline int Move::nx() const {
+    return (data >> 6) & 7;
+}
 
+inline int Move::ny() const {
+    return (data >> 9) & 7;
+}
 
+inline int Move::special() const {
+    return data == 0 ? -1 : data >> 12;
+}
 
+// the move as 16 bits for storage
+inline uint16_t Move::pack() const {
+    return data;
+}
+
+inline bool Move::operator==(const Move &other) const {
+    return data == other.data;
+}
 
+// fixed size list of moves that lives on the stack, so generating moves never allocates
+class MoveList {
+public:
+    void add(Move move);
+    void clear();
+    int size() const;
+    bool empty() const;
+    Move &operator [] (int i);
+    Move *begin();
+    Move *end();
+    const Move *begin() const;
+    const Move *end() const;
 
+    // more than any position can have
+    const static int capacity = 256;
 
+private:
+    Move moves [capacity];
+    int count = 0;
+};
+
+inline void MoveList::add(Move move) {
+    moves[count++] = move;
+}
+
+inline void MoveList::clear() {
+    count = 0;
+}
+
+inline int MoveList::size() const {
+    return count;
+}
+
+inline bool MoveList::empty() const {
+    return count == 0;
+}
+
+inline Move &MoveList::operator[](int i) {
+    return moves[i];
+}
+
+inline Move *MoveList::begin() {
+    return moves;
+}
+
+inline Move *MoveList::end() {
+    return moves + count;
+}
+
+inline const Move *MoveList::begin() const {
+    return moves;
+}
+
+inline const Move *MoveList::end() const {
+    return moves + count;
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include "BoardState.cpp"
+#include <algorithm>
+
+//
+// Hands out the moves of a search node one at a time, in the order most likely to cause a cutoff: the hash move,
+// captures and promotions by most valuable victim / least valuable attacker, the killer moves of this ply, then quiet
+// moves by history score. Moves are generated one stage at a time and only when the stage is reached, so a node that
+// cuts off on the hash move or a capture never generates its quiet moves. Each stage is only sorted as far as moves
+// are asked for. In quiescence search only the captures and promotions are generated and handed out.
+//
+
+class MovePicker {
+public:
+    MovePicker(BoardState &board, Move hashMove, const Move *killers, const int (*history)[64]);
+    MovePicker(BoardState &board);
+    Move next();
+    int generations() const;
+
+private:
+    enum Stage {
+        hashStage, generateCaptureStage, captureStage, killerStage, generateQuietStage, quietStage, doneStage
+    };
+
+    BoardState &board;
+    MoveList moves; // the moves of the current stage, the ones already handed out come first
+    int cursor; // next move to hand out
+    int generated = 0; // move lists generated so far, for the search stats
+    int scores [MoveList::capacity]; // sort key of moves[i]
+
+    Stage stage;
+    bool capturesOnly;
+    Move hashMove;
+    const Move *killers; // two per ply, most recent first
+    Move killersTried [2]; // the killers handed out, so the quiet stage can skip them
+    int killerIndex;
+    const int (*history)[64]; // history[from][to] of the side to move
+
+    int captureScore(Move move) const;
+    bool alreadyTried(Move move) const;
+    Move take(int i);
+    int best();
+};
+
+// nothing is generated until next is called
+MovePicker::MovePicker(BoardState &board, Move hashMove, const Move *killers, const int (*history)[64])
+    : board(board), hashMove(hashMove), killers(killers), history(history) {
+    cursor = 0;
+    killersTried[0] = killersTried[1] = noMove;
+    stage = hashStage;
+    capturesOnly = false;
+    killerIndex = 0;
+}
+
+// quiescence search picker, only generates captures and promotions
+MovePicker::MovePicker(BoardState &board) : board(board) {
+    cursor = 0;
+    hashMove = noMove;
+    killersTried[0] = killersTried[1] = noMove;
+    stage = generateCaptureStage;
+    capturesOnly = true;
+    killers = nullptr;
+    killerIndex = 0;
+    history = nullptr;
+}
+
+// returns the next move to search, or the illegal move (special = -1) when there are none left
+Move MovePicker::next() {
+    switch (stage) {
+        case hashStage:
+            stage = generateCaptureStage;
+            // the hash move comes from the table, which can hold a move of a different position with the same index
+            if(board.legalMove(hashMove)) return hashMove;
+            hashMove = noMove;
+            // fall through
+        case generateCaptureStage:
+            board.generateCaptures(moves);
+            generated++;
+            for(int i = 0; i < moves.size(); i++) {
+                scores[i] = captureScore(moves[i]);
+            }
+            stage = captureStage;
+            // fall through
+        case captureStage:
+            while(cursor < moves.size()) {
+                Move move = take(best());
+                if(!(move == hashMove)) return move;
+            }
+            if(capturesOnly) {
+                stage = doneStage;
+                return noMove;
+            }
+            stage = killerStage;
+            // fall through
+        case killerStage:
+            // killers are quiet moves that caused a cutoff at this ply in a sibling node. they only count if they are
+            // legal and quiet here and haven't been handed out yet
+            while(killerIndex < 2) {
+                Move killer = killers[killerIndex++];
+                if(killer == hashMove || !board.legalMove(killer) || killer.special() > 2 || board.isCapture(killer)) {
+                    continue;
+                }
+                killersTried[killerIndex - 1] = killer;
+                return killer;
+            }
+            stage = generateQuietStage;
+            // fall through
+        case generateQuietStage:
+            moves.clear();
+            cursor = 0;
+            board.generateQuiets(moves);
+            generated++;
+            for(int i = 0; i < moves.size(); i++) {
+                scores[i] = history[moves[i].from()][moves[i].to()];
+            }
+            stage = quietStage;
+            // fall through
+        case quietStage:
+            while(cursor < moves.size()) {
+                Move move = take(best());
+                if(!alreadyTried(move)) return move;
+            }
+            stage = doneStage;
+            // fall through
+        default:
+            return noMove;
+    }
+}
+
+// how many stages generated their moves
+int MovePicker::generations() const {
+    return generated;
+}
+
+// most valuable victim first, least valuable attacker breaks ties. promotions count the value of the new piece
+int MovePicker::captureScore(Move move) const {
+    int victim = board.capturedPiece(move);
+    int attacker = board.pieceAt(move.from());
+    int promotion = move.special() > 2 ? move.special() - 2 : 0;
+    return 16 * (BoardState::pieceValue[victim] + BoardState::pieceValue[promotion]) - BoardState::pieceValue[attacker];
+}
+
+// whether a quiet move was already handed out as the hash move or a killer
+bool MovePicker::alreadyTried(Move move) const {
+    return move == hashMove || move == killersTried[0] || move == killersTried[1];
+}
+
+// swaps moves[i] to the cursor and hands it out
+Move MovePicker::take(int i) {
+    std::swap(moves[cursor], moves[i]);
+    std::swap(scores[cursor], scores[i]);
+    return moves[cursor++];
+}
+
+// index of the highest scored move between the cursor and the end of the stage
+int MovePicker::best() {
+    int best = cursor;
+    for(int i = cursor + 1; i < moves.size(); i++) {
+        if(scores[i] > scores[best]) best = i;
+    }
+    return best;
+}
@@ -0,0 +1,266 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+//
+// Optional neural network eval, efficiently updatable (NNUE). The input is HalfKP: for each side, every piece other
+// than the kings on its square, paired with that side's king square, with the board flipped for black so both sides
+// see it from their own end. Each side keeps an accumulator, the first layer's output, in the board. A move only adds
+// and subtracts the weight rows of the pieces it moves, and a king move recomputes that side's accumulator. The small
+// layers after it run at eval.
+//
+// Network file, all little endian:
+//   magic "CENNUE01"
+//   uint32 feature count (40960), hidden size (256), layer 1 size (32), layer 2 size (32)
+//   int16 feature biases [256], int16 feature weights [40960][256]
+//   int32 layer 1 biases [32], int8 layer 1 weights [32][512] (side to move's half first)
+//   int32 layer 2 biases [32], int8 layer 2 weights [32][32]
+//   int32 output bias, int8 output weights [32]
+// Hidden values are clipped to 0..127 between layers, layer outputs are shifted down by weightShift first, and the
+// output divided by outputScale is the score in centipawns for the side to move.
+//
+
+class Network {
+public:
+    const static int pieceKinds = 10; // rook, knight, bishop, queen, pawn of the side itself, then of the other side
+    const static int features = 64 * pieceKinds * 64;
+    const static int hidden = 256;
+    const static int layer1 = 32;
+    const static int layer2 = 32;
+
+    static void load(const std::string &path);
+    static void unload();
+    static const Network *active();
+    static uint32_t generation();
+
+    static int feature(bool perspective, int kingSq, bool white, int id, int sq);
+    void reset(int16_t *accumulator) const;
+    void addFeature(int16_t *accumulator, int feature) const;
+    void subFeature(int16_t *accumulator, int feature) const;
+    int evaluate(const int16_t *own, const int16_t *other) const;
+
+private:
+    std::vector<int16_t> featureBias;
+    std::vector<int16_t> featureWeights;
+    std::vector<int32_t> layer1Bias;
+    std::vector<int8_t> layer1Weights;
+    std::vector<int32_t> layer2Bias;
+    std::vector<int8_t> layer2Weights;
+    int32_t outputBias = 0;
+    std::vector<int8_t> outputWeights;
+
+    static std::unique_ptr<Network> current;
+    static uint32_t loads;
+
+    static void clipAccumulator(const int16_t *values, uint8_t *clipped);
+    static int32_t dot(const uint8_t *input, const int8_t *weights, int count);
+
+    const static int weightShift = 6;
+    const static int outputScale = 16;
+};
+
+std::unique_ptr<Network> Network::current;
+uint32_t Network::loads = 0;
+
+// the first half of the first layer's output, for one side. aligned for the vector instructions
+struct Accumulator {
+    alignas(32) int16_t values [2][Network::hidden]; // from white's view, from black's view
+};
+
+// reads a network file and makes it the one eval uses. throws std::runtime_error if the file can't be read or doesn't
+// match the layout above. must not be called while a search is running
+void Network::load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if(!file) throw std::runtime_error("can't open network file " + path);
+
+    auto read = [&file, &path](void *data, size_t bytes) {
+        if(!file.read(static_cast<char *>(data), std::streamsize(bytes))) {
+            throw std::runtime_error("network file " + path + " is too short");
+        }
+    };
+    char magic [8];
+    read(magic, sizeof(magic));
+    if(memcmp(magic, "CENNUE01", sizeof(magic)) != 0) throw std::runtime_error(path + " is not a network file");
+    uint32_t sizes [4];
+    read(sizes, sizeof(sizes));
+    if(sizes[0] != features || sizes[1] != hidden || sizes[2] != layer1 || sizes[3] != layer2) {
+        throw std::runtime_error("network file " + path + " has the wrong layer sizes");
+    }
+
+    std::unique_ptr<Network> network(new Network());
+    auto readVector = [&read](auto &vector, size_t count) {
+        vector.resize(count);
+        read(vector.data(), count * sizeof(vector[0]));
+    };
+    readVector(network->featureBias, hidden);
+    readVector(network->featureWeights, size_t(features) * hidden);
+    readVector(network->layer1Bias, layer1);
+    readVector(network->layer1Weights, size_t(layer1) * 2 * hidden);
+    readVector(network->layer2Bias, layer2);
+    readVector(network->layer2Weights, size_t(layer2) * layer1);
+    read(&network->outputBias, sizeof(outputBias));
+    readVector(network->outputWeights, layer2);
+
+    current = std::move(network);
+    loads++;
+}
+
+// goes back to the heuristic eval
+void Network::unload() {
+    current.reset();
+    loads++;
+}
+
+// the network eval uses, nullptr for the heuristic eval
+inline const Network *Network::active() {
+    return current.get();
+}
+
+// changes every time a network is loaded or unloaded, so boards can tell whether their accumulators are still valid
+inline uint32_t Network::generation() {
+    return loads;
+}
+
+// input index of a piece seen by one side. id is the piece id, never the king
+inline int Network::feature(bool perspective, int kingSq, bool white, int id, int sq) {
+    if(!perspective) {
+        kingSq ^= 56;
+        sq ^= 56;
+    }
+    int kind = (id == 6 ? 4 : id - 1) + (white == perspective ? 0 : 5);
+    return (kingSq * pieceKinds + kind) * 64 + sq;
+}
+
+// starts an accumulator with no pieces
+void Network::reset(int16_t *accumulator) const {
+    memcpy(accumulator, featureBias.data(), hidden * sizeof(int16_t));
+}
+
+// adds the weights of an input to one side's accumulator, 16 or 8 values at a time where the cpu can
+inline void Network::addFeature(int16_t *accumulator, int feature) const {
+    const int16_t *row = &featureWeights[size_t(feature) * hidden];
+#if defined(__AVX2__)
+    for(int i = 0; i < hidden; i += 16) {
+        auto *values = reinterpret_cast<__m256i *>(accumulator + i);
+        __m256i weights = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+        _mm256_store_si256(values, _mm256_add_epi16(_mm256_load_si256(values), weights));
+    }
+#elif defined(__SSE2__)
+    for(int i = 0; i < hidden; i += 8) {
+        auto *values = reinterpret_cast<__m128i *>(accumulator + i);
+        __m128i weights = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        _mm_store_si128(values, _mm_add_epi16(_mm_load_si128(values), weights));
+    }
+#else
+    for(int i = 0; i < hidden; i++) accumulator[i] += row[i];
+#endif
+}
+
+// takes the weights of an input back out of one side's accumulator
+inline void Network::subFeature(int16_t *accumulator, int feature) const {
+    const int16_t *row = &featureWeights[size_t(feature) * hidden];
+#if defined(__AVX2__)
+    for(int i = 0; i < hidden; i += 16) {
+        auto *values = reinterpret_cast<__m256i *>(accumulator + i);
+        __m256i weights = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+        _mm256_store_si256(values, _mm256_sub_epi16(_mm256_load_si256(values), weights));
+    }
+#elif defined(__SSE2__)
+    for(int i = 0; i < hidden; i += 8) {
+        auto *values = reinterpret_cast<__m128i *>(accumulator + i);
+        __m128i weights = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        _mm_store_si128(values, _mm_sub_epi16(_mm_load_si128(values), weights));
+    }
+#else
+    for(int i = 0; i < hidden; i++) accumulator[i] -= row[i];
+#endif
+}
+
+// runs the layers after the accumulators. own is the accumulator of the side to move, the score is for that side
+int Network::evaluate(const int16_t *own, const int16_t *other) const {
+    auto clip = [](int value) {
+        return value < 0 ? 0 : value > 127 ? 127 : value;
+    };
+
+    alignas(32) uint8_t input [2 * hidden];
+    clipAccumulator(own, input);
+    clipAccumulator(other, input + hidden);
+
+    alignas(32) uint8_t hidden1 [layer1];
+    for(int o = 0; o < layer1; o++) {
+        int32_t sum = layer1Bias[o] + dot(input, &layer1Weights[size_t(o) * 2 * hidden], 2 * hidden);
+        hidden1[o] = uint8_t(clip(sum >> weightShift));
+    }
+
+    uint8_t hidden2 [layer2];
+    for(int o = 0; o < layer2; o++) {
+        int32_t sum = layer2Bias[o] + dot(hidden1, &layer2Weights[size_t(o) * layer1], layer1);
+        hidden2[o] = uint8_t(clip(sum >> weightShift));
+    }
+
+    int32_t output = outputBias;
+    for(int i = 0; i < layer2; i++) output += hidden2[i] * outputWeights[i];
+    return output / outputScale;
+}
+
+// clips the hidden values of an accumulator to 0..127, as the input of layer 1
+void Network::clipAccumulator(const int16_t *values, uint8_t *clipped) {
+#if defined(__SSE2__)
+    // packing to unsigned 8 bits saturates at 0 and 255, the min takes it down to 127
+    __m128i top = _mm_set1_epi8(127);
+    for(int i = 0; i < hidden; i += 16) {
+        __m128i low = _mm_load_si128(reinterpret_cast<const __m128i *>(values + i));
+        __m128i high = _mm_load_si128(reinterpret_cast<const __m128i *>(values + i + 8));
+        __m128i packed = _mm_min_epu8(_mm_packus_epi16(low, high), top);
+        _mm_store_si128(reinterpret_cast<__m128i *>(clipped + i), packed);
+    }
+#else
+    for(int i = 0; i < hidden; i++) {
+        clipped[i] = uint8_t(values[i] < 0 ? 0 : values[i] > 127 ? 127 : values[i]);
+    }
+#endif
+}
+
+// sum of input[i] * weights[i], count is a multiple of 32. inputs are at most 127, so with AVX2 two neighbouring
+// products can be added in 16 bits without overflow
+int32_t Network::dot(const uint8_t *input, const int8_t *weights, int count) {
+#if defined(__AVX2__)
+    __m256i sum = _mm256_setzero_si256();
+    for(int i = 0; i < count; i += 32) {
+        __m256i in = _mm256_load_si256(reinterpret_cast<const __m256i *>(input + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i));
+        __m256i pairs = _mm256_maddubs_epi16(in, w);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(pairs, _mm256_set1_epi16(1)));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    return _mm_cvtsi128_si32(half);
+#elif defined(__SSE2__)
+    // widened to 16 bits, then multiplied and added in pairs into 32 bits
+    __m128i sum = _mm_setzero_si128();
+    __m128i zero = _mm_setzero_si128();
+    for(int i = 0; i < count; i += 16) {
+        __m128i in = _mm_load_si128(reinterpret_cast<const __m128i *>(input + i));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i));
+        __m128i sign = _mm_cmpgt_epi8(zero, w);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpacklo_epi8(in, zero), _mm_unpacklo_epi8(w, sign)));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpackhi_epi8(in, zero), _mm_unpackhi_epi8(w, sign)));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+#else
+    int32_t sum = 0;
+    for(int i = 0; i < count; i++) sum += input[i] * weights[i];
+    return sum;
+#endif
+}
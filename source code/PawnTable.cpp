@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+//
+// Cache of the pawn structure part of eval, indexed by a hash of the pawns alone. Pawns move rarely compared to the
+// other pieces, so most evals in a search find their pawn structure already scored. Each search thread has its own
+// table, so there is no locking.
+//
+
+struct PawnEntry {
+    uint64_t key;
+    int score; // centipawns, + for white
+    uint8_t openFiles [2]; // files without a pawn of white (0) or black (1), bit i for file i
+};
+
+class PawnTable {
+public:
+    PawnTable();
+    bool probe(uint64_t key, PawnEntry *&entry);
+    uint64_t probeCount() const;
+    uint64_t hitCount() const;
+    void resetCounts();
+
+private:
+    const static int size = 1 << 14;
+    std::vector<PawnEntry> entries;
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+};
+
+// no real pawn key is all ones in practice, so that marks an empty entry
+PawnTable::PawnTable() : entries(size, PawnEntry{~0ULL, 0, {0, 0}}) {}
+
+// points entry at the slot for key. returns true if it already holds key, otherwise the caller fills it in
+bool PawnTable::probe(uint64_t key, PawnEntry *&entry) {
+    entry = &entries[key & (size - 1)];
+    probes++;
+    if(entry->key != key) return false;
+    hits++;
+    return true;
+}
+
+uint64_t PawnTable::probeCount() const {
+    return probes;
+}
+
+uint64_t PawnTable::hitCount() const {
+    return hits;
+}
+
+// starts probeCount and hitCount over, for a new search. the entries are kept
+void PawnTable::resetCounts() {
+    probes = 0;
+    hits = 0;
+}
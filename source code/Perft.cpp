@@ -0,0 +1,121 @@
+#pragma once
+#include "BoardState.cpp"
+#include <chrono>
+#include <iomanip>
+
+//
+// Move generator check. Counts the leaf nodes of the legal move tree to a fixed depth and compares them with counts
+// that are known to be correct. Any difference means a move is being generated wrong, made wrong or unmade wrong.
+// Divide prints the count below each root move, so a wrong total can be narrowed down one move at a time.
+//
+
+class Perft {
+public:
+    static uint64_t count(BoardState &board, int depth);
+    static uint64_t divide(BoardState &board, int depth);
+    static bool runSuite();
+
+private:
+    struct Position {
+        const char *name;
+        const char *fen;
+        int depth;
+        uint64_t nodes;
+    };
+    const static Position suite [];
+};
+
+// standard positions with their known counts, chosen so every rule of move generation is exercised
+const Perft::Position Perft::suite [] = {
+    {"start position", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603},
+    {"rook endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624},
+    {"promotions", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333},
+    {"promotions mirrored", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 4, 422333},
+    {"discovered checks", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487},
+    {"middlegame", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594},
+    {"illegal en passant 1", "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", 6, 1134888},
+    {"illegal en passant 2", "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1", 6, 1015133},
+    {"en passant gives check", "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", 6, 1440467},
+    {"short castle gives check", "5k2/8/8/8/8/8/8/4K2R w K - 0 1", 6, 661072},
+    {"long castle gives check", "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1", 6, 803711},
+    {"castling rights", "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1", 4, 1274206},
+    {"castling prevented", "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1", 4, 1720476},
+    {"promote out of check", "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1", 6, 3821001},
+    {"discovered check", "8/8/1P2K3/8/2n5/1q6/8/5k2 b - - 0 1", 5, 1004658},
+    {"promote to give check", "4k3/1P6/8/8/8/8/K7/8 w - - 0 1", 6, 217342},
+    {"underpromote to give check", "8/P1k5/K7/8/8/8/8/8 w - - 0 1", 6, 92683},
+    {"self stalemate", "K1k5/8/P7/8/8/8/8/8 w - - 0 1", 6, 2217},
+    {"stalemate and checkmate 1", "8/k1P5/8/1K6/8/8/8/8 w - - 0 1", 7, 567584},
+    {"stalemate and checkmate 2", "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1", 4, 23527},
+};
+
+// number of legal move sequences of length depth from the board. every generated move is legal, so the last ply is
+// counted without playing its moves
+uint64_t Perft::count(BoardState &board, int depth) {
+    if(depth <= 0) return 1;
+
+    MoveList moves;
+    board.generateMoves(moves);
+    if(depth == 1) return uint64_t(moves.size());
+
+    uint64_t nodes = 0;
+    for(Move move : moves) {
+        Undo undo = board.makeMove(move);
+        nodes += count(board, depth - 1);
+        board.unmakeMove(move, undo);
+    }
+    return nodes;
+}
+
+// like count, but prints the count below each legal root move and the time taken
+uint64_t Perft::divide(BoardState &board, int depth) {
+    auto start = std::chrono::steady_clock::now();
+    MoveList moves;
+    board.generateMoves(moves);
+    uint64_t total = 0;
+
+    for(Move move : moves) {
+        std::string name = board.moveString(move);
+        Undo undo = board.makeMove(move);
+        uint64_t nodes = count(board, depth - 1);
+        std::cout << name << ": " << nodes << "\n";
+        total += nodes;
+        board.unmakeMove(move, undo);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "\nnodes: " << total << "\ntime(ms): " << int(seconds * 1000) << "\nnodes/sec: "
+    << uint64_t(total / std::max(seconds, 1e-9)) << "\n";
+    return total;
+}
+
+// runs every suite position and prints its count next to the expected one. returns true if all of them match
+bool Perft::runSuite() {
+    bool passed = true;
+    uint64_t totalNodes = 0;
+    double totalSeconds = 0;
+
+    std::cout << std::left << std::setw(28) << "position" << std::right << std::setw(6) << "depth" << std::setw(12)
+    << "nodes" << std::setw(12) << "expected" << std::setw(12) << "nodes/sec" << "\n";
+    for(const Position &position : suite) {
+        BoardState board = BoardState::fromFEN(position.fen);
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = count(board, position.depth);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        totalNodes += nodes;
+        totalSeconds += seconds;
+
+        bool ok = nodes == position.nodes;
+        passed = passed && ok;
+        std::cout << std::left << std::setw(28) << position.name << std::right << std::setw(6) << position.depth
+        << std::setw(12) << nodes << std::setw(12) << position.nodes << std::setw(12)
+        << uint64_t(nodes / std::max(seconds, 1e-9)) << (ok ? "" : "  FAILED") << "\n";
+    }
+
+    std::cout << "\ntotal nodes: " << totalNodes << "\ntotal time(ms): " << int(totalSeconds * 1000)
+    << "\nnodes/sec: " << uint64_t(totalNodes / std::max(totalSeconds, 1e-9)) << "\n"
+    << (passed ? "all positions passed" : "some positions FAILED") << "\n";
+    return passed;
+}
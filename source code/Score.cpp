@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+
+//
+// Search scores. A score is in centipawns from the point of view of the side to move, except near the ends of the
+// range, which count plies to a result instead: checkmating in n plies scores mateScore - n and being checkmated in n
+// plies -(mateScore - n), so a quicker mate scores further out. Tablebase wins sit just inside the mates the same way.
+// Every score fits in 16 bits, which is how the transposition table stores them.
+//
+
+typedef int32_t Score;
+
+const Score mateScore = 10000; // being checkmated on the board scores -mateScore
+const Score mateInMaxPly = mateScore - 256; // scores at least this far out are mates
+const Score tableWinScore = mateInMaxPly - 1; // a tablebase win at the root, one ply later is one less
+const Score tableWinInMaxPly = tableWinScore - 256; // scores at least this far out count plies
+const Score infiniteScore = 32000; // beyond every real score
+const Score maxEvalScore = tableWinInMaxPly - 1; // static eval is clamped to this, see BoardState::staticEval
+
+// the bands must not overlap: a static eval is never read as a tablebase or mate score, and every score, infinite
+// included, fits the table's 16 bits
+static_assert(maxEvalScore < tableWinInMaxPly && tableWinInMaxPly < tableWinScore && tableWinScore < mateInMaxPly
+              && mateInMaxPly < mateScore && mateScore < infiniteScore && infiniteScore <= INT16_MAX,
+              "score bands overlap");
+
+// score for checkmating the side to move's opponent ply plies from the root
+inline Score mateIn(int ply) {
+    return mateScore - ply;
+}
+
+// score for being checkmated ply plies from the root
+inline Score matedIn(int ply) {
+    return -mateScore + ply;
+}
+
+inline bool isMateScore(Score score) {
+    return std::abs(score) >= mateInMaxPly;
+}
+
+// moves to mate, positive if the side to move mates and negative if it gets mated. only for mate scores
+inline int mateMoves(Score score) {
+    return score > 0 ? (mateScore - score + 1) / 2 : -(mateScore + score) / 2;
+}
+
+// a score counted from the root as the transposition table keeps it, counted from the node ply plies down. a mate
+// found through a position is the same number of plies away from it whichever path leads there
+inline Score toTable(Score score, int ply) {
+    return score >= tableWinInMaxPly ? score + ply : score <= -tableWinInMaxPly ? score - ply : score;
+}
+
+// a score from the transposition table, counted from the root again
+inline Score fromTable(Score score, int ply) {
+    return score >= tableWinInMaxPly ? score - ply : score <= -tableWinInMaxPly ? score + ply : score;
+}
@@ -0,0 +1,625 @@
+#pragma once
+#include "BoardState.cpp"
+#include "KeyHistory.cpp"
+#include "TranspositionTable.cpp"
+#include "MovePicker.cpp"
+#include "SearchStats.cpp"
+#include "Tablebase.cpp"
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <functional>
+
+//
+// Finds the best move of a position with alpha beta search. Searches run Lazy SMP: every thread searches the same root
+// on its own copy of the board and they share nothing but the transposition table and the stop flag. Helper threads
+// skip some depths so they run ahead of the main thread and fill the table with results it picks up.
+//
+
+// everything one search thread owns. aligned to cache lines so the counters of neighbouring threads in the vector
+// never share one. the pawn table and the move ordering tables are kept from one search to the next, the rest is set
+// up again for each
+struct alignas(64) SearchThread {
+    int id; // 0 for the main thread
+    BoardState board;
+    KeyHistory keys; // the game before the root, then the line being searched
+    SearchStats stats;
+    Move best = noMove;
+    Score score = 0; // of the deepest finished iteration, for the side to move
+    std::vector<Move> pv; // best line of the deepest finished iteration, starting with best
+    PawnTable pawnTable;
+
+    // pvTable[ply] holds the best line found from ply on, pvLength[ply] is where it ends. a node builds its line from
+    // its best move and the line of the child at ply + 1
+    Move pvTable [65][65];
+    int pvLength [65]{};
+
+    // move ordering
+    Move killers [65][2]{}; // by ply, quiet moves that last caused a cutoff there, noMove (all bits 0) if none yet
+    int history [2][64][64]{}; // by side, from and to square, how often a quiet move caused a cutoff
+};
+
+// progress of a search, handed to the reporter after every iteration the main thread finishes, and once more at the
+// end if a helper's result is used instead
+struct SearchInfo {
+    int depth;
+    Score score; // from the point of view of the side to move
+    uint64_t nodes; // all threads. helper threads are only counted in steps of 1024
+    std::chrono::milliseconds time;
+    Move best;
+    std::vector<Move> pv; // best line, starting with best
+};
+
+// a move at the root with its score from the last search of it
+struct RootMove {
+    Score score;
+    Move move;
+};
+
+class Search {
+public:
+    explicit Search(TranspositionTable &table);
+    void setThreads(int count);
+    void clear();
+    void setNodeLimit(uint64_t nodes);
+    void setReporter(std::function<void(const SearchInfo &)> callback);
+    Move bestMove(const BoardState &root, std::chrono::milliseconds budget, int maxDepth = maxSearchDepth);
+    Move bestMove(const BoardState &root, const KeyHistory &history, std::chrono::milliseconds budget,
+                  int maxDepth = maxSearchDepth);
+    void stop();
+    uint64_t nodeCount() const;
+    uint64_t mainThreadNodes() const;
+    int depthReached() const;
+    Score bestScore() const;
+    const std::vector<Move> &principalVariation() const;
+    const SearchStats &stats() const;
+
+    // how many moves in the future we look with minimax at most, the time budget usually stops the search first
+    const static int maxSearchDepth = 64;
+
+private:
+    TranspositionTable &table;
+    int threadCount = 1;
+    std::vector<SearchThread> threads; // on the heap, the history tables are too big for the stack
+    uint64_t nodeLimit = 0; // 0 for none
+    std::function<void(const SearchInfo &)> reporter;
+    std::atomic<bool> stopped{false};
+    std::atomic<uint64_t> searchedNodes{0}; // running total of all threads, for reports
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point deadline;
+    SearchStats totals; // all threads of the last search
+    uint64_t mainNodes = 0; // the main thread's share of totals.nodes
+    Score score = 0; // of the last search
+    std::vector<Move> pv; // of the last search
+
+    // history scores stay within plus or minus this
+    const static int maxHistory = 16384;
+    // quiescence skips captures that leave the score this many centipawns short of alpha even after winning the piece
+    const static int deltaMargin = 200;
+    // null move pruning passes instead of moving and searches this many plies less, one more from nullDeepDepth on
+    const static int nullReduction = 2;
+    const static int nullDeepDepth = 7;
+    // a null move cutoff is checked with a normal search when the side to move has this much piece material or less,
+    // because with few pieces passing may really be better than every move (zugzwang)
+    const static int nullVerifyMaterial = 6;
+    // late move reductions apply to quiet moves after this many moves have been searched, from this depth on
+    const static int lmrMoveIndex = 3;
+    const static int lmrDepth = 3;
+    // iterations from this depth on start with a window this many centipawns either side of the last score
+    const static int aspirationDepth = 4;
+    const static int aspirationWindow = 25;
+
+    void iterate(SearchThread &thread, int maxDepth);
+    Score searchRoot(SearchThread &thread, std::vector<RootMove> &rootMoves, int depth, Score alpha, Score beta);
+    Score minimax(SearchThread &thread, int depth, int ply, Score alpha, Score beta, bool nullAllowed = true,
+                  bool verification = false);
+    Score quiescence(SearchThread &thread, int ply, Score alpha, Score beta);
+    bool outOfTime(SearchThread &thread);
+    static void updateHistory(int &entry, int bonus);
+    static Score tableScore(int wdl, int ply);
+};
+
+// helper thread i skips depth d when ((d + skipPhase[i]) / skipSize[i]) is odd, so helpers spread over depths
+const int skipSize [16] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4};
+const int skipPhase [16] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3};
+
+Search::Search(TranspositionTable &table) : table(table) {
+    clear();
+}
+
+// changing the number of threads starts them all over, as clear does
+void Search::setThreads(int count) {
+    count = std::max(count, 1);
+    if(count == threadCount) return;
+    threadCount = count;
+    clear();
+}
+
+// forgets what the threads learned in earlier searches: pawn tables, killer moves and history. for a new game
+void Search::clear() {
+    threads = std::vector<SearchThread>(threadCount);
+    for(int i = 0; i < threadCount; i++) threads[i].id = i;
+}
+
+// stops searches once all threads together have searched about this many nodes, checked every 1024 nodes. 0 removes
+// the limit
+void Search::setNodeLimit(uint64_t nodes) {
+    nodeLimit = nodes;
+}
+
+// the callback runs on the main search thread, so it has to be quick and safe to call from there
+void Search::setReporter(std::function<void(const SearchInfo &)> callback) {
+    reporter = std::move(callback);
+}
+
+// ends a running search as soon as possible, bestMove then returns the best move found so far. safe to call from any
+// thread, but only stops a search that has already started
+void Search::stop() {
+    stopped = true;
+}
+
+// nodes searched by all threads in the last search
+uint64_t Search::nodeCount() const {
+    return totals.nodes;
+}
+
+// nodes searched by the main thread alone in the last search. with a core for every thread this is what the time to
+// depth depends on, however many nodes the helpers searched alongside
+uint64_t Search::mainThreadNodes() const {
+    return mainNodes;
+}
+
+// deepest iteration finished in the last search
+int Search::depthReached() const {
+    return totals.depth;
+}
+
+// score of the last search's best move, from the point of view of the side to move
+Score Search::bestScore() const {
+    return score;
+}
+
+// best line of the last search, as far as the deepest finished iteration saw it
+const std::vector<Move> &Search::principalVariation() const {
+    return pv;
+}
+
+// counters of the last search, added up over all threads. iteration results are those of the thread whose move was
+// used
+const SearchStats &Search::stats() const {
+    return totals;
+}
+
+// best move of a position with no game before it, so nothing before the root can be repeated
+Move Search::bestMove(const BoardState &root, std::chrono::milliseconds budget, int maxDepth) {
+    static const KeyHistory none{};
+    return bestMove(root, none, budget, maxDepth);
+}
+
+// method to find the best move from the current board state. history holds the positions of the game before root, for
+// finding repetitions. runs iterative deepening on every thread until the budget runs out or a thread finishes
+// maxDepth, then returns the best move of the thread that got deepest
+Move Search::bestMove(const BoardState &root, const KeyHistory &history, std::chrono::milliseconds budget,
+                      int maxDepth) {
+    table.newSearch();
+    start = std::chrono::steady_clock::now();
+    deadline = start + budget;
+    stopped = false;
+    searchedNodes = 0;
+
+    // with few enough pieces the tablebases know the best move, nothing is searched
+    if(root.pieceCount() <= Tablebase::maxPieces() && !root.hasCastlingRights()) {
+        BoardState board = root;
+        Move move;
+        int wdl;
+        if(Tablebase::probeRoot(board, history, move, wdl)) {
+            totals = SearchStats();
+            mainNodes = 0;
+            totals.tbHits = 1;
+            totals.depth = 1;
+            score = tableScore(wdl, 1);
+            pv = {move};
+            if(reporter) {
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                reporter({1, score, 0, std::chrono::duration_cast<std::chrono::milliseconds>(elapsed), move, pv});
+            }
+            return move;
+        }
+    }
+
+    for(auto &thread : threads) {
+        thread.board = root;
+        thread.keys = history;
+        thread.stats = SearchStats();
+        thread.best = noMove;
+        thread.score = 0;
+        thread.pv.clear();
+        thread.pawnTable.resetCounts();
+    }
+
+    std::vector<std::thread> helpers;
+    for(int i = 1; i < threadCount; i++) {
+        helpers.emplace_back(&Search::iterate, this, std::ref(threads[i]), maxDepth);
+    }
+    iterate(threads[0], maxDepth);
+    stopped = true;
+    for(auto &helper : helpers) helper.join();
+
+    // helpers skip depths, so one may have finished a deeper iteration than the main thread. its result is used then
+    SearchThread *chosen = &threads[0];
+    for(auto &thread : threads) {
+        if(thread.stats.depth > chosen->stats.depth) chosen = &thread;
+    }
+
+    totals = chosen->stats;
+    mainNodes = threads[0].stats.nodes;
+    for(auto &thread : threads) {
+        thread.stats.pawnProbes = thread.pawnTable.probeCount();
+        thread.stats.pawnHits = thread.pawnTable.hitCount();
+        if(&thread == chosen) {
+            totals.pawnProbes = thread.stats.pawnProbes;
+            totals.pawnHits = thread.stats.pawnHits;
+        } else {
+            totals.add(thread.stats);
+        }
+    }
+    score = chosen->score;
+    pv = chosen->pv;
+    if(chosen != &threads[0] && reporter) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        reporter({totals.depth, score, totals.nodes, std::chrono::duration_cast<std::chrono::milliseconds>(elapsed),
+                  chosen->best, pv});
+    }
+    return chosen->best;
+}
+
+// iterative deepening on one thread. searches one move deeper each iteration and keeps the best move of the deepest
+// finished iteration in thread.best. from aspirationDepth on each iteration first searches a narrow window around the
+// score of the last one, and only widens it when the score falls outside
+void Search::iterate(SearchThread &thread, int maxDepth) {
+    // root moves with their score from the last iteration, best first
+    std::vector<RootMove> rootMoves;
+    MoveList moves;
+    thread.board.generateMoves(moves);
+    for(auto move : moves) rootMoves.push_back({0, move});
+    if(rootMoves.empty()) {
+        thread.score = thread.board.inCheck(thread.board.isWhiteTurn()) ? matedIn(0) : 0;
+        return;
+    }
+    thread.best = rootMoves[0].move;
+    thread.pv = {thread.best};
+    Score score = 0;
+
+    for(int depth = 1; depth <= maxDepth && !stopped; depth++) {
+        if(thread.id > 0) {
+            int i = (thread.id - 1) % 16;
+            if(((depth + skipPhase[i]) / skipSize[i]) % 2 == 1) continue;
+        }
+
+        uint64_t nodesBefore = thread.stats.nodes;
+        auto iterationStart = std::chrono::steady_clock::now();
+
+        int delta = aspirationWindow;
+        Score alpha = depth >= aspirationDepth ? std::max(score - delta, -infiniteScore) : -infiniteScore;
+        Score beta = depth >= aspirationDepth ? std::min(score + delta, infiniteScore) : infiniteScore;
+        while(true) {
+            Score result = searchRoot(thread, rootMoves, depth, alpha, beta);
+            if(stopped) break;
+
+            // fail low or high, search again with the window widened on that side
+            delta *= 2;
+            if(result <= alpha) {
+                alpha = std::max(result - delta, -infiniteScore);
+            } else if(result >= beta) {
+                beta = std::min(result + delta, infiniteScore);
+            } else {
+                score = result;
+                break;
+            }
+        }
+
+        if(!stopped) {
+            thread.score = score;
+            auto now = std::chrono::steady_clock::now();
+            SearchStats &stats = thread.stats;
+            stats.depth = depth;
+            stats.iterationNodes[depth] = stats.nodes - nodesBefore;
+            stats.iterationTime[depth] = std::chrono::duration_cast<std::chrono::milliseconds>(now - iterationStart);
+            if(thread.id == 0 && reporter) {
+                auto elapsed = now - start;
+                uint64_t nodes = searchedNodes.load(std::memory_order_relaxed) + thread.stats.nodes % 1024;
+                reporter({depth, score, nodes, std::chrono::duration_cast<std::chrono::milliseconds>(elapsed),
+                          thread.best, thread.pv});
+            }
+            // whichever thread gets there first ends the search, the others are only helping it
+            if(depth == maxDepth) stopped = true;
+        }
+    }
+}
+
+// searches every root move within alpha and beta with principal variation search and returns the best score. the
+// first move gets the full window, the rest a null window that only proves they are no better, and a move that is
+// better is searched again with the full window. a move that raises alpha becomes thread.best right away, so an
+// iteration cut short by the clock still keeps what it found. afterwards the moves are sorted best first
+Score Search::searchRoot(SearchThread &thread, std::vector<RootMove> &rootMoves, int depth, Score alpha, Score beta) {
+    BoardState &board = thread.board;
+    Score bestScore = -infiniteScore;
+    for(auto &rootMove : rootMoves) rootMove.score = -infiniteScore;
+
+    for(size_t i = 0; i < rootMoves.size(); i++) {
+        Move move = rootMoves[i].move;
+        thread.keys.push(board.getHash());
+        Undo undo = board.makeMove(move);
+        Score score;
+        if(i == 0) {
+            score = -minimax(thread, depth - 1, 1, -beta, -alpha);
+        } else {
+            score = -minimax(thread, depth - 1, 1, -alpha - 1, -alpha);
+            if(score > alpha && score < beta) score = -minimax(thread, depth - 1, 1, -beta, -alpha);
+        }
+        board.unmakeMove(move, undo);
+        thread.keys.pop();
+        if(stopped) break;
+
+        rootMoves[i].score = score;
+        bestScore = std::max(score, bestScore);
+        if(score > alpha) {
+            alpha = score;
+            thread.best = move;
+            thread.pv.assign(1, move);
+            thread.pv.insert(thread.pv.end(), thread.pvTable[1] + 1, thread.pvTable[1] + thread.pvLength[1]);
+            if(score >= beta) break;
+        }
+    }
+
+    // the next search starts with the moves that scored best in this one
+    std::stable_sort(rootMoves.begin(), rootMoves.end(), [](const RootMove &a, const RootMove &b) {
+        return a.score > b.score;
+    });
+    return bestScore;
+}
+
+// minimax with alpha beta pruning, written in negamax form: scores are from the point of view of the side to move.
+// ply is the distance from the root. the board is changed in place with makeMove/unmakeMove and restored before
+// returning. nullAllowed is false right after a null move, verification is set for the search that checks a null
+// move cutoff at the same node
+Score Search::minimax(SearchThread &thread, int depth, int ply, Score alpha, Score beta, bool nullAllowed,
+                      bool verification) {
+    BoardState &board = thread.board;
+    thread.pvLength[ply] = ply;
+
+    // out of time, the result is thrown away by iterate
+    if(outOfTime(thread)) return 0;
+
+    // draws. whichever side could do better than a draw from a repeated position could have done so the first time,
+    // so a repetition inside the search counts as the third. fifty moves without a capture or pawn move end the game
+    if(thread.keys.isRepetition(board) || board.fiftyMoveDraw()) return 0;
+
+    if(ply >= maxSearchDepth) {
+        thread.stats.evals++;
+        return board.isWhiteTurn() ? board.eval(thread.pawnTable) : -board.eval(thread.pawnTable);
+    }
+    if(depth == 0) return quiescence(thread, ply, alpha, beta);
+
+    // mate distance pruning: no line from here can do better than mating on the next ply or worse than being mated
+    // right here, so if a shorter mate is already known elsewhere this node can't change anything
+    alpha = std::max(alpha, matedIn(ply));
+    beta = std::min(beta, mateIn(ply + 1));
+    if(alpha >= beta) return alpha;
+
+    // reuse the result of an earlier search of this position if it was deep enough
+    TTEntry entry{};
+    thread.stats.ttProbes++;
+    if(table.probe(board.getHash(), entry)) {
+        thread.stats.ttHits++;
+        Score score = fromTable(entry.score, ply);
+        if(entry.depth >= depth && (entry.bound() == boundExact || (entry.bound() == boundLower && score >= beta)
+                                    || (entry.bound() == boundUpper && score <= alpha))) {
+            thread.stats.ttCutoffs++;
+            return score;
+        }
+    }
+    // the endgame tablebases know the result. only probed right after a capture or pawn move, which is how every line
+    // gets into them, because the fifty move rule is part of the result. the tables don't know castling
+    if(board.pieceCount() <= Tablebase::maxPieces() && board.getHalfmoveClock() == 0 && !board.hasCastlingRights()) {
+        int wdl;
+        if(Tablebase::probeWdl(board, wdl)) {
+            thread.stats.tbHits++;
+            Score score = tableScore(wdl, ply);
+            Bound bound = wdl == Tablebase::win ? boundLower : wdl == Tablebase::loss ? boundUpper : boundExact;
+            if(bound == boundExact || (bound == boundLower ? score >= beta : score <= alpha)) {
+                table.store(board.getHash(), std::min(depth + 6, maxSearchDepth), bound, toTable(score, ply), noMove);
+                return score;
+            }
+        }
+    }
+
+    Score alphaOrig = alpha;
+    Move best = noMove;
+
+    bool white = board.isWhiteTurn();
+    bool inCheck = board.inCheck(white);
+
+    // null move pruning: if the side to move could pass and a shallower search still fails high, a real move will
+    // almost always fail high too. never in check, where passing is illegal, never with only pawns left, and only at
+    // null window nodes: a cutoff at a node with a full window would cut the principal variation itself
+    int material = board.pieceMaterial(white);
+    if(nullAllowed && !inCheck && alpha + 1 == beta && depth >= nullReduction + 1 && material > 0
+       && std::abs(beta) < tableWinInMaxPly) {
+        int reduced = depth - 1 - nullReduction - (depth >= nullDeepDepth ? 1 : 0);
+        Undo undo = board.makeNullMove();
+        Score score = -minimax(thread, reduced, ply + 1, -beta, -beta + 1, false);
+        board.unmakeNullMove(undo);
+        if(stopped.load(std::memory_order_relaxed)) return 0;
+
+        // with little material left the cutoff is only trusted if a search without null moves agrees. that search is
+        // of this same node, so it leaves the table alone and its line is dropped again
+        if(score >= beta && material <= nullVerifyMaterial) {
+            score = minimax(thread, reduced, ply, beta - 1, beta, false, true);
+            thread.pvLength[ply] = ply;
+            if(stopped.load(std::memory_order_relaxed)) return 0;
+        }
+        if(score >= beta) {
+            thread.stats.nullCutoffs++;
+            return beta;
+        }
+    }
+
+    int side = white ? 0 : 1;
+    MovePicker picker(board, Move(entry.move), thread.killers[ply], thread.history[side]);
+
+    // quiet moves searched before the one that cut off, their history goes down
+    Move quietsTried [64];
+    int quietCount = 0;
+
+    Score maxEval = -infiniteScore;
+    int legalMoves = 0;
+    for(Move move = picker.next(); move.special() != -1; move = picker.next()) {
+        bool quiet = move.special() <= 2 && !board.isCapture(move);
+        thread.keys.push(board.getHash());
+        Undo undo = board.makeMove(move);
+        legalMoves++;
+
+        // late move reductions: quiet moves this far down the order rarely raise alpha, so they get a shallower
+        // search first, less shallow for moves with a good history. only if one does raise alpha is it searched again
+        // at full depth. checks and evasions are never reduced
+        int reduction = 0;
+        if(quiet && depth >= lmrDepth && legalMoves > lmrMoveIndex && !inCheck && !board.inCheck(!white)) {
+            int history = thread.history[side][move.from()][move.to()];
+            reduction = 1 + (legalMoves > 2 * lmrMoveIndex ? 1 : 0) + (depth >= 2 * lmrDepth ? 1 : 0);
+            if(history > maxHistory / 2) reduction--;
+            if(history < 0) reduction++;
+            reduction = std::max(0, std::min(reduction, depth - 2));
+        }
+        // principal variation search: after the first move the others only have to be shown to be no better, which a
+        // null window around alpha does faster. one that turns out better is searched again with the full window
+        Score eval;
+        if(legalMoves == 1) {
+            eval = -minimax(thread, depth - 1, ply + 1, -beta, -alpha);
+        } else {
+            eval = -minimax(thread, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha);
+            if(eval > alpha && reduction > 0) {
+                thread.stats.reSearches++;
+                eval = -minimax(thread, depth - 1, ply + 1, -alpha - 1, -alpha);
+            }
+            if(eval > alpha && eval < beta) eval = -minimax(thread, depth - 1, ply + 1, -beta, -alpha);
+        }
+        board.unmakeMove(move, undo);
+        thread.keys.pop();
+        if(stopped.load(std::memory_order_relaxed)) break;
+
+        if(eval > maxEval) {
+            maxEval = eval;
+            best = move;
+        }
+        if(eval > alpha) {
+            alpha = eval;
+            // this move and the child's line are the best line from here
+            Move *line = thread.pvTable[ply];
+            Move *childLine = thread.pvTable[ply + 1];
+            line[ply] = move;
+            std::copy(childLine + ply + 1, childLine + thread.pvLength[ply + 1], line + ply + 1);
+            thread.pvLength[ply] = std::max(thread.pvLength[ply + 1], ply + 1);
+        }
+        if(beta <= alpha) {
+            thread.stats.cutoffs++;
+            thread.stats.cutoffsByMove[std::min(legalMoves, 8) - 1]++;
+            if(quiet) {
+                Move *killers = thread.killers[ply];
+                if(!(killers[0] == move)) {
+                    killers[1] = killers[0];
+                    killers[0] = move;
+                }
+                int bonus = depth * depth;
+                updateHistory(thread.history[side][move.from()][move.to()], bonus);
+                for(int i = 0; i < quietCount; i++) {
+                    Move &tried = quietsTried[i];
+                    updateHistory(thread.history[side][tried.from()][tried.to()], -bonus);
+                }
+            }
+            break;
+        }
+        if(quiet && quietCount < 64) quietsTried[quietCount++] = move;
+    }
+    thread.stats.moveGens += picker.generations();
+    if(stopped.load(std::memory_order_relaxed)) return 0;
+
+    // checkmate or stalemate
+    if(legalMoves == 0) maxEval = inCheck ? matedIn(ply) : 0;
+
+    // a null move verification search is shallower than the node it verifies, which stores its own result
+    if(!verification) {
+        Bound bound = maxEval <= alphaOrig ? boundUpper : maxEval >= beta ? boundLower : boundExact;
+        table.store(board.getHash(), depth, bound, toTable(maxEval, ply), best);
+    }
+
+    return maxEval;
+}
+
+// searches only captures and promotions until the position is quiet, so the static eval is never taken in the middle
+// of an exchange. the side to move may stand pat on the static eval instead of capturing. in check there is no
+// standing pat, so every evasion gets searched one ply deep instead
+Score Search::quiescence(SearchThread &thread, int ply, Score alpha, Score beta) {
+    BoardState &board = thread.board;
+    bool white = board.isWhiteTurn();
+    thread.pvLength[ply] = ply;
+
+    if(board.inCheck(white)) return minimax(thread, 1, ply, alpha, beta);
+    if(outOfTime(thread)) return 0;
+    thread.stats.qnodes++;
+    thread.stats.evals++;
+
+    Score standPat = white ? board.eval(thread.pawnTable) : -board.eval(thread.pawnTable);
+    if(standPat >= beta || ply >= maxSearchDepth) return standPat;
+    alpha = std::max(standPat, alpha);
+    Score maxEval = standPat;
+
+    MovePicker picker(board);
+    for(Move move = picker.next(); move.special() != -1; move = picker.next()) {
+        // delta pruning: skip captures that can't reach alpha even if the piece is won for free
+        int gain = 100 * BoardState::pieceValue[board.capturedPiece(move)];
+        if(move.special() > 2) gain += 100 * (BoardState::pieceValue[move.special() - 2] - BoardState::pieceValue[6]);
+        if(standPat + gain + deltaMargin <= alpha) continue;
+
+        // captures and promotions can't be repeated past, so the key isn't pushed onto thread.keys
+        Undo undo = board.makeMove(move);
+        Score eval = -quiescence(thread, ply + 1, -beta, -alpha);
+        board.unmakeMove(move, undo);
+        if(stopped.load(std::memory_order_relaxed)) return 0;
+
+        maxEval = std::max(eval, maxEval);
+        alpha = std::max(eval, alpha);
+        if(beta <= alpha) break;
+    }
+    thread.stats.moveGens += picker.generations();
+
+    return maxEval;
+}
+
+// counts a node, returns true once the search has to stop. the clock is only read every 1024 nodes
+bool Search::outOfTime(SearchThread &thread) {
+    if(stopped.load(std::memory_order_relaxed)) return true;
+    if(++thread.stats.nodes % 1024 == 0) {
+        uint64_t searched = searchedNodes.fetch_add(1024, std::memory_order_relaxed) + 1024;
+        if(std::chrono::steady_clock::now() >= deadline || (nodeLimit != 0 && searched >= nodeLimit)) {
+            stopped = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+// moves a history score towards +-maxHistory. the closer it already is, the smaller the step, so scores never overflow
+// and recent cutoffs outweigh old ones
+void Search::updateHistory(int &entry, int bonus) {
+    entry += bonus - entry * abs(bonus) / maxHistory;
+}
+
+// score of a tablebase result at ply. wins and losses are just inside the mate scores, nearer ones further out. the
+// ones the fifty move rule saves are draws, a centipawn towards the side that would have won
+Score Search::tableScore(int wdl, int ply) {
+    if(wdl == Tablebase::win) return tableWinScore - ply;
+    if(wdl == Tablebase::loss) return -tableWinScore + ply;
+    return wdl == Tablebase::cursedWin ? 1 : wdl == Tablebase::blessedLoss ? -1 : 0;
+}
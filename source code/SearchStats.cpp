@@ -0,0 +1,91 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+//
+// Counters of one search, for tuning. Every search thread fills in its own copy without locking and the copies are
+// added up when the search is over. Counting is a few increments per node, nothing is printed while searching.
+//
+
+struct SearchStats {
+    uint64_t nodes = 0; // every position visited, quiescence included
+    uint64_t qnodes = 0; // positions visited by quiescence search
+    uint64_t ttProbes = 0;
+    uint64_t ttHits = 0;
+    uint64_t ttCutoffs = 0; // nodes answered by the transposition table without a search
+    uint64_t cutoffs = 0; // beta cutoffs outside of quiescence search
+    uint64_t cutoffsByMove [8]{}; // beta cutoffs by the index of the move that caused them, the last counts the rest
+    uint64_t nullCutoffs = 0; // nodes pruned by null move pruning
+    uint64_t reSearches = 0; // reduced searches that raised alpha and were searched again at full depth
+    uint64_t evals = 0;
+    uint64_t moveGens = 0; // move lists generated by the move pickers
+    uint64_t pawnProbes = 0;
+    uint64_t pawnHits = 0;
+    uint64_t tbHits = 0; // positions answered by the endgame tablebases
+
+    // of the thread whose result was used, by depth
+    int depth = 0; // deepest finished iteration
+    uint64_t iterationNodes [65]{}; // nodes the iteration took
+    std::chrono::milliseconds iterationTime [65]{}; // time the iteration took
+
+    void add(const SearchStats &other);
+    double firstMoveCutoffRate() const;
+    double ttHitRate() const;
+    double pawnHitRate() const;
+    double branchingFactor() const;
+    std::string summary() const;
+};
+
+// adds the counters of another thread. the iteration results stay those of this thread
+void SearchStats::add(const SearchStats &other) {
+    nodes += other.nodes;
+    qnodes += other.qnodes;
+    ttProbes += other.ttProbes;
+    ttHits += other.ttHits;
+    ttCutoffs += other.ttCutoffs;
+    cutoffs += other.cutoffs;
+    for(int i = 0; i < 8; i++) cutoffsByMove[i] += other.cutoffsByMove[i];
+    nullCutoffs += other.nullCutoffs;
+    reSearches += other.reSearches;
+    evals += other.evals;
+    moveGens += other.moveGens;
+    pawnProbes += other.pawnProbes;
+    pawnHits += other.pawnHits;
+    tbHits += other.tbHits;
+}
+
+// share of beta cutoffs that came from the first move tried, a measure of move ordering
+double SearchStats::firstMoveCutoffRate() const {
+    return cutoffs == 0 ? 0 : double(cutoffsByMove[0]) / double(cutoffs);
+}
+
+double SearchStats::ttHitRate() const {
+    return ttProbes == 0 ? 0 : double(ttHits) / double(ttProbes);
+}
+
+// share of evals that found their pawn structure in the pawn table
+double SearchStats::pawnHitRate() const {
+    return pawnProbes == 0 ? 0 : double(pawnHits) / double(pawnProbes);
+}
+
+// effective branching factor: how many times more nodes the last finished iteration took than the one before it.
+// 0 until two iterations are done
+double SearchStats::branchingFactor() const {
+    if(depth < 2 || iterationNodes[depth - 1] == 0) return 0;
+    return double(iterationNodes[depth]) / double(iterationNodes[depth - 1]);
+}
+
+// the counters on one line, like "nodes 5000 qnodes 3000 tthit 41.0% ..."
+std::string SearchStats::summary() const {
+    std::ostringstream str;
+    str << std::fixed << std::setprecision(1) << "nodes " << nodes << " qnodes " << qnodes << " tthit "
+    << 100 * ttHitRate() << "% ttcut " << ttCutoffs << " cutoffs " << cutoffs << " firstcut "
+    << 100 * firstMoveCutoffRate() << "% nullcut " << nullCutoffs << " researches " << reSearches << " evals " << evals
+    << " pawnhit " << 100 * pawnHitRate() << "% movegens " << moveGens << " tbhits " << tbHits << " ebf "
+    << std::setprecision(2) << branchingFactor() << " cutsbymove";
+    for(uint64_t count : cutoffsByMove) str << " " << count;
+    return str.str();
+}
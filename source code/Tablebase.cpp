@@ -0,0 +1,861 @@
+#pragma once
+#include "BoardState.cpp"
+#include "KeyHistory.cpp"
+#include "MappedFile.cpp"
+#include <algorithm>
+#include <climits>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//
+// Syzygy endgame tablebases. For every position with few enough pieces a WDL table gives the result with perfect play
+// (win, draw or loss, and whether the fifty move rule changes it) and a DTZ table the number of plies to the next
+// capture or pawn move on the way there. Tables are found by file name in the given directories and memory mapped, so
+// a probe only reads the pages it lands on. Search ends lines that reach a table with the WDL result, and the root
+// picks its move by DTZ without searching at all.
+//
+// A table stores each position once, up to symmetry, at an index computed from where its pieces stand. The values are
+// compressed by recursive pairing, where frequent pairs of values become new symbols, then by canonical Huffman codes
+// in blocks of fixed size, with a sparse index to find the block of an index. The layout is that of the probing code
+// published with the tables.
+//
+
+class Tablebase {
+public:
+    static int init(const std::string &paths);
+    static void clear();
+    static int maxPieces();
+    static bool probeWdl(BoardState &board, int &wdl);
+    static bool probeDtz(BoardState &board, int &dtz);
+    static bool probeRoot(BoardState &board, const KeyHistory &history, Move &best, int &wdl);
+
+    // WDL results, for the side to move
+    const static int loss = -2;
+    const static int blessedLoss = -1; // lost, but the fifty move rule ends the game first
+    const static int draw = 0;
+    const static int cursedWin = 1; // won, but the fifty move rule ends the game first
+    const static int win = 2;
+
+private:
+    const static int maxTablePieces = 7;
+
+    // how a probe went. a DTZ table may only store the other side to move, and positions where the best move is a
+    // capture or pawn move (zeroing the fifty move counter) have no reliable DTZ value
+    enum State { failed, ok, otherSide, zeroingBest };
+    enum Flag { sideToMove = 1, mapped = 2, winPlies = 4, lossPlies = 8, wide = 16, singleValue = 128 };
+
+    // decoding data for one side to move and file of the leading pawn of a table
+    struct Pairs {
+        int flags = 0;
+        size_t blockSize = 0; // bytes
+        size_t span = 0; // positions between sparse index entries
+        int blocks = 0;
+        int maxSymbolLength = 0;
+        int minSymbolLength = 0; // the value of every position with singleValue
+        const uint8_t *lowestSymbol = nullptr; // by code length, the first symbol with a code that long
+        const uint8_t *symbolPairs = nullptr; // 3 bytes per symbol, the two 12 bit symbols it stands for
+        const uint8_t *blockLength = nullptr; // positions in each block, minus one
+        int blockLengthSize = 0;
+        const uint8_t *sparseIndex = nullptr; // 6 bytes per entry: a block and the offset in it of a position
+        size_t sparseIndexSize = 0;
+        const uint8_t *data = nullptr; // compressed blocks
+        std::vector<uint64_t> base; // by code length, the lowest code of that length left aligned in 64 bits
+        std::vector<uint8_t> symbolLength; // values a symbol stands for, minus one
+        int pieces [maxTablePieces]{}; // table piece codes in the order they are indexed
+        uint64_t groupIndex [maxTablePieces + 1]{}; // factor of each group of like pieces in the index
+        int groupLength [maxTablePieces + 1]{}; // pieces in each group, 0 after the last
+        int mapIndex [4]{}; // DTZ only, start of the value map of each WDL result
+    };
+
+    // one mapped file
+    struct TableFile {
+        const uint8_t *address = nullptr;
+        size_t size = 0;
+        const uint8_t *map = nullptr; // DTZ only, the value maps
+        Pairs pairs [2][4]; // by side to move (one side for DTZ) and file of the leading pawn (a to d, or a only)
+    };
+
+    // one combination of material, like KRvKN
+    struct Entry {
+        uint64_t key; // material as named, the first side white
+        uint64_t key2; // the first side black
+        int pieceCount;
+        bool hasPawns;
+        bool hasUniquePieces; // some piece other than a king is the only one of its kind and color
+        int pawnCount [2]; // pawns of the leading color, pawns of the other. the leading color has fewer pawns
+        TableFile wdl;
+        TableFile dtz; // unmapped if there is no DTZ file
+    };
+
+    // squares and counts the index is built from, filled once at startup
+    struct Indexing {
+        int mapPawns [64]; // a2 to h7, higher towards the edge and for lower ranks
+        int mapB1H1H7 [64]; // squares below the a1-h8 diagonal, 0 to 27
+        int mapA1D1D4 [64]; // the a1-d1-d4 triangle, 0 to 9 with the diagonal last
+        int mapKK [10][64]; // two kings with the first in the triangle, 0 to 461
+        int binomial [6][64]; // ways to pick k of n squares
+        int leadPawnIndex [6][64]; // by leading pawn count and square of the leading pawn
+        int leadPawnsSize [6][4]; // by leading pawn count and file
+
+        Indexing();
+    };
+
+    static const Indexing indexing;
+    static std::vector<std::unique_ptr<Entry>> entries;
+    static std::unordered_map<uint64_t, Entry *> byKey;
+    static int largest;
+
+    static bool mapFile(const std::string &path, const uint8_t magic [4], TableFile &file);
+    static void unmapFile(TableFile &file);
+    static void setup(Entry &entry, TableFile &file, bool dtz);
+    static void setGroups(const Entry &entry, Pairs &pairs, const int order [2], int file);
+    static const uint8_t *setSizes(Pairs &pairs, const uint8_t *data);
+    static uint8_t setSymbolLength(Pairs &pairs, int symbol, std::vector<bool> &visited);
+    static const uint8_t *setDtzMap(TableFile &file, const uint8_t *data, int maxFile);
+
+    static int probeTable(const BoardState &board, bool dtz, int wdl, State &state);
+    static int decompress(const Pairs &pairs, uint64_t index);
+    static int mapDtz(const TableFile &file, const Pairs &pairs, int value, int wdl);
+    static int search(BoardState &board, bool zeroing, State &state);
+    static int dtz(BoardState &board, State &state);
+    static int dtzBeforeZeroing(int wdl);
+
+    static uint64_t materialKey(const int white [7], const int black [7]);
+    static int offDiagonal(int sq);
+    static int leftSymbol(const Pairs &pairs, int symbol);
+    static int rightSymbol(const Pairs &pairs, int symbol);
+    static uint32_t little16(const uint8_t *bytes);
+    static uint32_t little32(const uint8_t *bytes);
+    static uint64_t big(const uint8_t *bytes, int length);
+
+    // table piece kind of each piece id: 1 pawn, 2 knight, 3 bishop, 4 rook, 5 queen, 6 king. black adds 8
+    constexpr const static int tableKind [7] = {0, 4, 2, 3, 5, 6, 1};
+    // root moves that win or lose within the fifty move rule rank above or below all others by this much
+    const static int maxDtz = 1 << 18;
+};
+
+constexpr const int Tablebase::tableKind [7];
+const Tablebase::Indexing Tablebase::indexing;
+std::vector<std::unique_ptr<Tablebase::Entry>> Tablebase::entries;
+std::unordered_map<uint64_t, Tablebase::Entry *> Tablebase::byKey;
+int Tablebase::largest = 0;
+
+Tablebase::Indexing::Indexing() : mapPawns{}, mapB1H1H7{}, mapA1D1D4{}, mapKK{}, binomial{}, leadPawnIndex{},
+                                  leadPawnsSize{} {
+    int code = 0;
+    for(int sq = 0; sq < 64; sq++) {
+        if(offDiagonal(sq) < 0) mapB1H1H7[sq] = code++;
+    }
+
+    // a1 to d4, the squares on the diagonal last
+    std::vector<int> diagonal;
+    code = 0;
+    for(int sq = 0; sq <= 27; sq++) {
+        if(offDiagonal(sq) < 0 && sq % 8 <= 3) {
+            mapA1D1D4[sq] = code++;
+        } else if(offDiagonal(sq) == 0 && sq % 8 <= 3) {
+            diagonal.push_back(sq);
+        }
+    }
+    for(int sq : diagonal) mapA1D1D4[sq] = code++;
+
+    // kings that don't touch. with the first king on the diagonal the second is not above it, and with both on it
+    // they come last
+    std::vector<std::pair<int, int>> bothOnDiagonal;
+    code = 0;
+    for(int index = 0; index < 10; index++) {
+        for(int first = 0; first <= 27; first++) {
+            // squares outside the triangle are 0 too, b1 is the real 0
+            if(mapA1D1D4[first] != index || (index == 0 && first != 1)) continue;
+            for(int second = 0; second < 64; second++) {
+                if((kingAttacks(bit(first)) | bit(first)) & bit(second)) continue;
+                if(offDiagonal(first) == 0 && offDiagonal(second) > 0) continue;
+                if(offDiagonal(first) == 0 && offDiagonal(second) == 0) {
+                    bothOnDiagonal.emplace_back(index, second);
+                } else {
+                    mapKK[index][second] = code++;
+                }
+            }
+        }
+    }
+    for(auto &kings : bothOnDiagonal) mapKK[kings.first][kings.second] = code++;
+
+    binomial[0][0] = 1;
+    for(int n = 1; n < 64; n++) {
+        for(int k = 0; k < 6 && k <= n; k++) {
+            binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) + (k < n ? binomial[k][n - 1] : 0);
+        }
+    }
+
+    // the leading pawn is the one with the highest mapPawns, the other leading pawns can only stand on the squares
+    // mapped lower. each file of the leading pawn has its own table, so its index starts over at every file
+    int available = 47;
+    for(int leadPawns = 1; leadPawns <= 5; leadPawns++) {
+        for(int file = 0; file < 4; file++) {
+            int index = 0;
+            for(int rank = 1; rank <= 6; rank++) {
+                int sq = square(file, rank);
+                if(leadPawns == 1) {
+                    mapPawns[sq] = available--;
+                    mapPawns[sq ^ 7] = available--;
+                }
+                leadPawnIndex[leadPawns][sq] = index;
+                index += binomial[leadPawns - 1][mapPawns[sq]];
+            }
+            leadPawnsSize[leadPawns][file] = index;
+        }
+    }
+}
+
+// finds the tables in a list of directories separated by ':' and maps them, replacing the tables found before. a
+// table is used if its WDL file (like KRvK.rtbw) is found, its DTZ file (KRvK.rtbz) is optional. returns the number of
+// tables. must not be called while a search is running
+int Tablebase::init(const std::string &paths) {
+    const uint8_t wdlMagic [4] = {0x71, 0xE8, 0x23, 0x5D};
+    const uint8_t dtzMagic [4] = {0xD7, 0x66, 0x0C, 0xA5};
+    clear();
+
+    std::vector<std::string> directories;
+    std::istringstream list(paths);
+    for(std::string directory; std::getline(list, directory, ':');) {
+        if(!directory.empty()) directories.push_back(directory);
+    }
+
+    for(const std::string &directory : directories) {
+        std::error_code error;
+        for(const auto &item : std::filesystem::directory_iterator(directory, error)) {
+            if(item.path().extension() != ".rtbw") continue;
+            std::string name = item.path().stem().string();
+
+            // two sides like KQP and KR, each a king and then queens, rooks, bishops, knights and pawns
+            size_t split = name.find('v');
+            if(split == std::string::npos || name.size() - 1 > maxTablePieces) continue;
+            int counts [2][7]{};
+            bool valid = true;
+            for(size_t i = 0; i < name.size(); i++) {
+                if(i == split) continue;
+                size_t kind = std::string(" PNBRQK").find(name[i]);
+                bool first = i == 0 || i == split + 1;
+                if(kind == std::string::npos || kind == 0 || (kind == 6) != first) valid = false;
+                if(valid) counts[i < split ? 0 : 1][kind]++;
+            }
+            if(!valid || split == 0 || split == name.size() - 1) continue;
+
+            auto entry = std::make_unique<Entry>();
+            entry->key = materialKey(counts[0], counts[1]);
+            entry->key2 = materialKey(counts[1], counts[0]);
+            if(byKey.count(entry->key) != 0) continue;
+            entry->pieceCount = int(name.size()) - 1;
+            entry->hasPawns = counts[0][1] + counts[1][1] > 0;
+            entry->hasUniquePieces = false;
+            for(auto &side : counts) {
+                for(int kind = 1; kind <= 5; kind++) {
+                    if(side[kind] == 1) entry->hasUniquePieces = true;
+                }
+            }
+            // the side with fewer pawns leads, it compresses better. white leads if both have the same
+            bool whiteLeads = counts[1][1] == 0 || (counts[0][1] > 0 && counts[1][1] >= counts[0][1]);
+            entry->pawnCount[0] = counts[whiteLeads ? 0 : 1][1];
+            entry->pawnCount[1] = counts[whiteLeads ? 1 : 0][1];
+
+            if(!mapFile(item.path().string(), wdlMagic, entry->wdl)) continue;
+            setup(*entry, entry->wdl, false);
+            for(const std::string &dtzDirectory : directories) {
+                if(mapFile(dtzDirectory + "/" + name + ".rtbz", dtzMagic, entry->dtz)) {
+                    setup(*entry, entry->dtz, true);
+                    break;
+                }
+            }
+
+            byKey[entry->key] = entry.get();
+            byKey[entry->key2] = entry.get();
+            largest = std::max(largest, entry->pieceCount);
+            entries.push_back(std::move(entry));
+        }
+    }
+    return int(entries.size());
+}
+
+// unmaps every table
+void Tablebase::clear() {
+    for(auto &entry : entries) {
+        unmapFile(entry->wdl);
+        unmapFile(entry->dtz);
+    }
+    entries.clear();
+    byKey.clear();
+    largest = 0;
+}
+
+// most pieces of any table found, kings included. 0 without tables
+inline int Tablebase::maxPieces() {
+    return largest;
+}
+
+// WDL result of the position for the side to move. returns false if a table it needs is missing. the position must
+// have no castling rights
+bool Tablebase::probeWdl(BoardState &board, int &wdl) {
+    State state = ok;
+    wdl = search(board, false, state);
+    return state != failed;
+}
+
+// plies to the next capture or pawn move with perfect play, positive if the side to move wins and negative if it
+// loses, 0 for a draw. wins and losses the fifty move rule saves are 100 more. returns false if a table it needs is
+// missing. the position must have no castling rights
+bool Tablebase::probeDtz(BoardState &board, int &value) {
+    State state = ok;
+    value = dtz(board, state);
+    return state != failed;
+}
+
+// picks the root move that wins fastest, or failing that draws, or failing that loses slowest, where fast is counted
+// in plies to the next capture or pawn move and the fifty move counter of the board is taken into account. wdl is the
+// result after the move. a move back to a position in history, the game before the board, is scored as a draw like the
+// search does. returns false if a table is missing. the position must have no castling rights
+bool Tablebase::probeRoot(BoardState &board, const KeyHistory &history, Move &best, int &wdl) {
+    MoveList moves;
+    board.generateMoves(moves);
+    if(moves.empty()) return false;
+    int clock = board.getHalfmoveClock();
+    KeyHistory keys = history;
+    keys.push(board.getHash());
+
+    int bestRank = INT_MIN;
+    for(Move move : moves) {
+        State state = ok;
+        Undo undo = board.makeMove(move);
+        int value;
+        if(keys.isRepetition(board)) {
+            value = 0;
+        } else if(board.getHalfmoveClock() == 0) {
+            // after a capture or pawn move the counter starts over, the WDL result is all that matters
+            value = dtzBeforeZeroing(-search(board, false, state));
+        } else {
+            value = -dtz(board, state);
+            value = value > 0 ? value + 1 : value < 0 ? value - 1 : value;
+        }
+        if(value == 2 && board.checkmate()) value = 1;
+        board.unmakeMove(move, undo);
+        if(state == failed) return false;
+
+        // wins the fifty move rule doesn't stop first by distance, then the ones it does. the same for losses
+        int rank = 0;
+        if(value > 0) {
+            rank = value + clock <= 99 ? 2 * maxDtz - value : maxDtz - (value + clock);
+        } else if(value < 0) {
+            rank = -value + clock <= 99 ? -2 * maxDtz - value : -maxDtz - value + clock;
+        }
+        if(rank > bestRank) {
+            bestRank = rank;
+            best = move;
+            wdl = rank > maxDtz ? win : rank > 0 ? cursedWin : rank == 0 ? draw : rank > -maxDtz ? blessedLoss : loss;
+        }
+    }
+    return true;
+}
+
+// maps a table file read only. returns false if it isn't there or isn't a table of the kind magic names
+bool Tablebase::mapFile(const std::string &path, const uint8_t magic [4], TableFile &file) {
+    file.address = mapReadOnly(path, file.size);
+    if(file.address == nullptr) return false;
+    // a table is a whole number of 64 byte lines after its 16 byte header
+    if(file.size % 64 != 16 || memcmp(file.address, magic, 4) != 0) {
+        unmapFile(file);
+        return false;
+    }
+    return true;
+}
+
+void Tablebase::unmapFile(TableFile &file) {
+    unmapReadOnly(file.address, file.size);
+    file = TableFile();
+}
+
+// reads the header of a mapped file: the piece order and grouping of each table, then the decoding data, the DTZ value
+// maps, the sparse indexes, the block lengths and the compressed blocks, each for all tables in turn
+void Tablebase::setup(Entry &entry, TableFile &file, bool dtz) {
+    const uint8_t *data = file.address + 4;
+    data++; // flags, which the material already tells
+
+    int sides = !dtz && entry.key != entry.key2 ? 2 : 1;
+    int maxFile = entry.hasPawns ? 3 : 0;
+    bool bothPawns = entry.hasPawns && entry.pawnCount[1] > 0;
+
+    for(int f = 0; f <= maxFile; f++) {
+        for(int i = 0; i < sides; i++) file.pairs[i][f] = Pairs();
+        // position of the leading group and the other side's pawns in the order groups are indexed, 15 for none
+        int order [2][2] = {{data[0] & 0xF, bothPawns ? data[1] & 0xF : 0xF},
+                            {data[0] >> 4, bothPawns ? data[1] >> 4 : 0xF}};
+        data += bothPawns ? 2 : 1;
+        for(int k = 0; k < entry.pieceCount; k++, data++) {
+            for(int i = 0; i < sides; i++) file.pairs[i][f].pieces[k] = i ? *data >> 4 : *data & 0xF;
+        }
+        for(int i = 0; i < sides; i++) setGroups(entry, file.pairs[i][f], order[i], f);
+    }
+    data += uintptr_t(data) & 1;
+
+    for(int f = 0; f <= maxFile; f++) {
+        for(int i = 0; i < sides; i++) data = setSizes(file.pairs[i][f], data);
+    }
+    if(dtz) data = setDtzMap(file, data, maxFile);
+    for(int f = 0; f <= maxFile; f++) {
+        for(int i = 0; i < sides; i++) {
+            file.pairs[i][f].sparseIndex = data;
+            data += file.pairs[i][f].sparseIndexSize * 6;
+        }
+    }
+    for(int f = 0; f <= maxFile; f++) {
+        for(int i = 0; i < sides; i++) {
+            file.pairs[i][f].blockLength = data;
+            data += file.pairs[i][f].blockLengthSize * 2;
+        }
+    }
+    for(int f = 0; f <= maxFile; f++) {
+        for(int i = 0; i < sides; i++) {
+            // blocks start on 64 byte lines
+            data = file.address + ((data - file.address + 63) & ~63);
+            file.pairs[i][f].data = data;
+            data += size_t(file.pairs[i][f].blocks) * file.pairs[i][f].blockSize;
+        }
+    }
+}
+
+// splits the pieces into groups that are indexed together: the leading pawns or the first two or three pieces, then
+// every run of like pieces. the index is the sum of each group's index times the product of the sizes of the groups
+// after it, in the order the table gives
+void Tablebase::setGroups(const Entry &entry, Pairs &pairs, const int order [2], int file) {
+    int n = 0;
+    int firstLength = entry.hasPawns ? 0 : entry.hasUniquePieces ? 3 : 2;
+    pairs.groupLength[n] = 1;
+    for(int i = 1; i < entry.pieceCount; i++) {
+        if(--firstLength > 0 || pairs.pieces[i] == pairs.pieces[i - 1]) {
+            pairs.groupLength[n]++;
+        } else {
+            pairs.groupLength[++n] = 1;
+        }
+    }
+    pairs.groupLength[++n] = 0;
+
+    bool bothPawns = entry.hasPawns && entry.pawnCount[1] > 0;
+    int next = bothPawns ? 2 : 1;
+    int freeSquares = 64 - pairs.groupLength[0] - (bothPawns ? pairs.groupLength[1] : 0);
+    uint64_t index = 1;
+    for(int k = 0; next < n || k == order[0] || k == order[1]; k++) {
+        if(k == order[0]) {
+            pairs.groupIndex[0] = index;
+            index *= entry.hasPawns ? indexing.leadPawnsSize[pairs.groupLength[0]][file]
+                     : entry.hasUniquePieces ? 31332 : 462;
+        } else if(k == order[1]) {
+            pairs.groupIndex[1] = index;
+            index *= indexing.binomial[pairs.groupLength[1]][48 - pairs.groupLength[0]];
+        } else {
+            pairs.groupIndex[next] = index;
+            index *= indexing.binomial[pairs.groupLength[next]][freeSquares];
+            freeSquares -= pairs.groupLength[next++];
+        }
+    }
+    pairs.groupIndex[n] = index;
+}
+
+// reads the block sizes and the Huffman code of one table. returns where its data ends
+const uint8_t *Tablebase::setSizes(Pairs &pairs, const uint8_t *data) {
+    pairs.flags = *data++;
+    if(pairs.flags & singleValue) {
+        pairs.minSymbolLength = *data++;
+        return data;
+    }
+
+    // the last group index is the number of positions
+    int groups = int(std::find(pairs.groupLength, pairs.groupLength + maxTablePieces + 1, 0) - pairs.groupLength);
+    uint64_t positions = pairs.groupIndex[groups];
+
+    pairs.blockSize = size_t(1) << *data++;
+    pairs.span = size_t(1) << *data++;
+    pairs.sparseIndexSize = size_t((positions + pairs.span - 1) / pairs.span);
+    int padding = *data++;
+    pairs.blocks = int(little32(data));
+    data += 4;
+    // padded so the sparse index never points past the end
+    pairs.blockLengthSize = pairs.blocks + padding;
+    pairs.maxSymbolLength = *data++;
+    pairs.minSymbolLength = *data++;
+    pairs.lowestSymbol = data;
+
+    // longer codes have lower values. base[i] is the lowest code of length minSymbolLength + i, so a code of that
+    // length, left aligned in 64 bits, is at least base[i] and less than base[i - 1]
+    pairs.base.assign(size_t(pairs.maxSymbolLength - pairs.minSymbolLength + 1), 0);
+    for(int i = int(pairs.base.size()) - 2; i >= 0; i--) {
+        pairs.base[i] = (pairs.base[i + 1] + little16(pairs.lowestSymbol + 2 * i)
+                         - little16(pairs.lowestSymbol + 2 * (i + 1))) / 2;
+    }
+    for(size_t i = 0; i < pairs.base.size(); i++) pairs.base[i] <<= 64 - i - pairs.minSymbolLength;
+    data += pairs.base.size() * 2;
+
+    pairs.symbolLength.assign(little16(data), 0);
+    data += 2;
+    pairs.symbolPairs = data;
+    std::vector<bool> visited(pairs.symbolLength.size());
+    for(int symbol = 0; symbol < int(pairs.symbolLength.size()); symbol++) {
+        if(!visited[symbol]) pairs.symbolLength[symbol] = setSymbolLength(pairs, symbol, visited);
+    }
+    return data + pairs.symbolLength.size() * 3 + (pairs.symbolLength.size() & 1);
+}
+
+// number of values a symbol stands for, minus one. a symbol stands for the values of its pair, or for one value if it
+// has no pair
+uint8_t Tablebase::setSymbolLength(Pairs &pairs, int symbol, std::vector<bool> &visited) {
+    visited[symbol] = true;
+    int right = rightSymbol(pairs, symbol);
+    if(right == 0xFFF) return 0;
+    int left = leftSymbol(pairs, symbol);
+    if(!visited[left]) pairs.symbolLength[left] = setSymbolLength(pairs, left, visited);
+    if(!visited[right]) pairs.symbolLength[right] = setSymbolLength(pairs, right, visited);
+    return uint8_t(pairs.symbolLength[left] + pairs.symbolLength[right] + 1);
+}
+
+// DTZ tables store the distances in order of how often they occur. these maps, one per WDL result, turn them back
+const uint8_t *Tablebase::setDtzMap(TableFile &file, const uint8_t *data, int maxFile) {
+    file.map = data;
+    for(int f = 0; f <= maxFile; f++) {
+        Pairs &pairs = file.pairs[0][f];
+        if(!(pairs.flags & mapped)) continue;
+        for(int i = 0; i < 4; i++) {
+            // each map starts with its length, the index is of the value after it
+            if(pairs.flags & wide) {
+                data += uintptr_t(data) & 1;
+                pairs.mapIndex[i] = int((data - file.map) / 2 + 1);
+                data += 2 * little16(data) + 2;
+            } else {
+                pairs.mapIndex[i] = int(data - file.map + 1);
+                data += *data + 1;
+            }
+        }
+    }
+    return data + (uintptr_t(data) & 1);
+}
+
+// looks the position up in the table of its material. wdl is the WDL result of the position, which DTZ values depend
+// on. sets state to failed if there is no table and to otherSide if a DTZ table only has the other side to move
+int Tablebase::probeTable(const BoardState &board, bool dtz, int wdl, State &state) {
+    int code [64]{};
+    int counts [2][7]{};
+    Bitboard all = 0;
+    for(int i = 0; i < 12; i++) {
+        bool white = i < 6;
+        Bitboard b = board.pieceBoard(white, i % 6 + 1);
+        int kind = tableKind[i % 6 + 1];
+        counts[white ? 0 : 1][kind] += popCount(b);
+        all |= b;
+        while(b) code[popLsb(b)] = kind + (white ? 0 : 8);
+    }
+    // the two kings alone are a draw, there is no table for them
+    if(popCount(all) == 2) return draw;
+
+    uint64_t key = materialKey(counts[0], counts[1]);
+    auto found = byKey.find(key);
+    if(found == byKey.end() || (dtz && found->second->dtz.address == nullptr)) {
+        state = failed;
+        return 0;
+    }
+    const Entry &entry = *found->second;
+    const TableFile &file = dtz ? entry.dtz : entry.wdl;
+
+    // tables have the side named first as white. if the board has it as black, or both sides have the same pieces and
+    // black is to move (only white to move is stored then), colors are swapped and the board turned around
+    bool blackToMove = !board.isWhiteTurn();
+    bool flip = (entry.key == entry.key2 && blackToMove) || key != entry.key;
+    int flipColor = flip ? 8 : 0;
+    int flipSquares = flip ? 56 : 0;
+    int stm = flip != blackToMove ? 1 : 0;
+
+    int squares [maxTablePieces]{};
+    int pieces [maxTablePieces]{};
+    int size = 0;
+    int leadPawnCount = 0;
+    Bitboard leadPawns = 0;
+    int tableFile = 0;
+    auto byMapPawns = [](int a, int b) { return indexing.mapPawns[a] < indexing.mapPawns[b]; };
+
+    // with pawns there is a table for each file a to d of the leading pawn, the one nearest the edge and lowest. every
+    // table starts with the pawns of the same color
+    if(entry.hasPawns) {
+        int pawn = file.pairs[0][0].pieces[0] ^ flipColor;
+        leadPawns = board.pieceBoard((pawn & 8) == 0, 6);
+        for(Bitboard b = leadPawns; b;) squares[size++] = popLsb(b) ^ flipSquares;
+        leadPawnCount = size;
+        std::swap(squares[0], *std::max_element(squares, squares + leadPawnCount, byMapPawns));
+        tableFile = std::min(squares[0] % 8, 7 - squares[0] % 8);
+    }
+    const Pairs &pairs = file.pairs[dtz ? 0 : stm][tableFile];
+
+    // a DTZ table stores one side to move only, unless the sides are the same without pawns
+    if(dtz && (pairs.flags & sideToMove) != stm && !(entry.key == entry.key2 && !entry.hasPawns)) {
+        state = otherSide;
+        return 0;
+    }
+
+    for(Bitboard b = all ^ leadPawns; b;) {
+        int sq = popLsb(b);
+        squares[size] = sq ^ flipSquares;
+        pieces[size++] = code[sq] ^ flipColor;
+    }
+    // into the order of the table
+    for(int i = leadPawnCount; i < size - 1; i++) {
+        for(int j = i + 1; j < size; j++) {
+            if(pairs.pieces[i] == pieces[j]) {
+                std::swap(pieces[i], pieces[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    // mirrored so the leading piece is on files a to d
+    if(squares[0] % 8 > 3) {
+        for(int i = 0; i < size; i++) squares[i] ^= 7;
+    }
+
+    uint64_t index;
+    if(entry.hasPawns) {
+        index = indexing.leadPawnIndex[leadPawnCount][squares[0]];
+        std::stable_sort(squares + 1, squares + leadPawnCount, byMapPawns);
+        for(int i = 1; i < leadPawnCount; i++) index += indexing.binomial[i][indexing.mapPawns[squares[i]]];
+    } else {
+        // without pawns also mirrored to ranks 1 to 4, and across the a1-h8 diagonal so the first piece of the leading
+        // group that is off it is below it
+        if(squares[0] / 8 > 3) {
+            for(int i = 0; i < size; i++) squares[i] ^= 56;
+        }
+        for(int i = 0; i < pairs.groupLength[0]; i++) {
+            if(offDiagonal(squares[i]) == 0) continue;
+            if(offDiagonal(squares[i]) > 0) {
+                for(int j = i; j < size; j++) squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+            }
+            break;
+        }
+
+        if(entry.hasUniquePieces) {
+            // three pieces together. the second and third can't stand where the ones before them do
+            int adjust1 = squares[1] > squares[0];
+            int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+            if(offDiagonal(squares[0])) {
+                index = (indexing.mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            } else if(offDiagonal(squares[1])) {
+                index = (6 * 63 + (squares[0] / 8) * 28 + indexing.mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+            } else if(offDiagonal(squares[2])) {
+                index = 6 * 63 * 62 + 4 * 28 * 62 + (squares[0] / 8) * 7 * 28 + (squares[1] / 8 - adjust1) * 28
+                        + indexing.mapB1H1H7[squares[2]];
+            } else {
+                index = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + (squares[0] / 8) * 7 * 6
+                        + (squares[1] / 8 - adjust1) * 6 + (squares[2] / 8 - adjust2);
+            }
+        } else {
+            index = indexing.mapKK[indexing.mapA1D1D4[squares[0]]][squares[1]];
+        }
+    }
+
+    // the other groups by the squares of their pieces, leaving out squares taken by the groups before them
+    index *= pairs.groupIndex[0];
+    int *groupSquares = squares + pairs.groupLength[0];
+    bool remainingPawns = entry.hasPawns && entry.pawnCount[1] > 0;
+    for(int next = 1; pairs.groupLength[next] != 0; next++) {
+        std::stable_sort(groupSquares, groupSquares + pairs.groupLength[next]);
+        uint64_t n = 0;
+        for(int i = 0; i < pairs.groupLength[next]; i++) {
+            int sq = groupSquares[i];
+            int adjust = int(std::count_if(squares, groupSquares, [sq](int other) { return sq > other; }));
+            n += indexing.binomial[i + 1][sq - adjust - (remainingPawns ? 8 : 0)];
+        }
+        remainingPawns = false;
+        index += n * pairs.groupIndex[next];
+        groupSquares += pairs.groupLength[next];
+    }
+
+    state = ok;
+    int value = decompress(pairs, index);
+    return dtz ? mapDtz(file, pairs, value, wdl) : value - 2;
+}
+
+// the value at an index of a table
+int Tablebase::decompress(const Pairs &pairs, uint64_t index) {
+    if(pairs.flags & singleValue) return pairs.minSymbolLength;
+
+    // the sparse index has the block and offset of every span positions, counted from the middle of the span. the
+    // block lengths lead from there to the block of the index
+    uint32_t k = uint32_t(index / pairs.span);
+    uint32_t block = little32(pairs.sparseIndex + 6 * k);
+    int offset = int(little16(pairs.sparseIndex + 6 * k + 4)) + int(index % pairs.span) - int(pairs.span / 2);
+    while(offset < 0) offset += int(little16(pairs.blockLength + 2 * --block)) + 1;
+    while(offset > int(little16(pairs.blockLength + 2 * block))) {
+        offset -= int(little16(pairs.blockLength + 2 * block++)) + 1;
+    }
+
+    // reads the block's codes until the symbol that covers the offset, refilling 32 bits at a time
+    const uint8_t *next = pairs.data + uint64_t(block) * pairs.blockSize;
+    uint64_t buffer = big(next, 8);
+    next += 8;
+    int bits = 64;
+    int symbol;
+    while(true) {
+        int length = 0;
+        while(buffer < pairs.base[length]) length++;
+        symbol = int((buffer - pairs.base[length]) >> (64 - length - pairs.minSymbolLength));
+        symbol += int(little16(pairs.lowestSymbol + 2 * length));
+        if(offset < pairs.symbolLength[symbol] + 1) break;
+
+        offset -= pairs.symbolLength[symbol] + 1;
+        length += pairs.minSymbolLength;
+        buffer <<= length;
+        bits -= length;
+        if(bits <= 32) {
+            bits += 32;
+            buffer |= big(next, 4) << (64 - bits);
+            next += 4;
+        }
+    }
+
+    // down the pairs to the single value at the offset
+    while(pairs.symbolLength[symbol] != 0) {
+        int left = leftSymbol(pairs, symbol);
+        if(offset < pairs.symbolLength[left] + 1) {
+            symbol = left;
+        } else {
+            offset -= pairs.symbolLength[left] + 1;
+            symbol = rightSymbol(pairs, symbol);
+        }
+    }
+    return leftSymbol(pairs, symbol);
+}
+
+// turns a stored DTZ value into plies to zeroing plus one
+int Tablebase::mapDtz(const TableFile &file, const Pairs &pairs, int value, int wdl) {
+    const int wdlMap [5] = {1, 3, 0, 2, 0}; // map of each WDL result, from loss
+    if(pairs.flags & mapped) {
+        int at = pairs.mapIndex[wdlMap[wdl + 2]] + value;
+        value = pairs.flags & wide ? int(little16(file.map + 2 * at)) : file.map[at];
+    }
+    // tables store moves instead of plies where that loses nothing
+    if((wdl == win && !(pairs.flags & winPlies)) || (wdl == loss && !(pairs.flags & lossPlies)) || wdl == cursedWin
+       || wdl == blessedLoss) {
+        value *= 2;
+    }
+    return value + 1;
+}
+
+// WDL result of the position. where a capture (or with zeroing, also a pawn move) is the best move the tables may
+// store any value, because it compresses better, so those moves are played and their results taken into account.
+// sets state to zeroingBest if one of them is the best move
+int Tablebase::search(BoardState &board, bool zeroing, State &state) {
+    int best = loss;
+    MoveList moves;
+    board.generateMoves(moves);
+    int tried = 0;
+    for(Move move : moves) {
+        if(!board.isCapture(move) && !(zeroing && board.pieceAt(move.from()) == 6)) continue;
+        tried++;
+        Undo undo = board.makeMove(move);
+        int value = -search(board, false, state);
+        board.unmakeMove(move, undo);
+        if(state == failed) return draw;
+        if(value > best) {
+            best = value;
+            if(value >= win) {
+                state = zeroingBest;
+                return value;
+            }
+        }
+    }
+
+    // if those were all the moves, the table's value can't be trusted (it doesn't know en passant, for one)
+    bool noMoreMoves = tried > 0 && tried == moves.size();
+    int value = best;
+    if(!noMoreMoves) {
+        value = probeTable(board, false, draw, state);
+        if(state == failed) return draw;
+    }
+    if(best >= value) {
+        state = best > draw || noMoreMoves ? zeroingBest : ok;
+        return best;
+    }
+    state = ok;
+    return value;
+}
+
+// DTZ of the position, see probeDtz
+int Tablebase::dtz(BoardState &board, State &state) {
+    state = ok;
+    int wdl = search(board, true, state);
+    if(state == failed || wdl == draw) return 0;
+    if(state == zeroingBest) return dtzBeforeZeroing(wdl);
+
+    int sign = wdl > 0 ? 1 : -1;
+    int value = probeTable(board, true, wdl, state);
+    if(state == failed) return 0;
+    if(state != otherSide) return (value + (wdl == blessedLoss || wdl == cursedWin ? 100 : 0)) * sign;
+
+    // the table has the other side to move, so one ply is searched for the move that wins fastest or loses slowest
+    int best = 0xFFFF;
+    MoveList moves;
+    board.generateMoves(moves);
+    for(Move move : moves) {
+        bool zeroingMove = board.isCapture(move) || board.pieceAt(move.from()) == 6;
+        Undo undo = board.makeMove(move);
+        // a capture or pawn move starts the count over, its DTZ is that of the move itself
+        value = zeroingMove ? -dtzBeforeZeroing(search(board, false, state)) : -dtz(board, state);
+        if(value == 1 && board.checkmate()) best = 1;
+        if(!zeroingMove) value += value > 0 ? 1 : value < 0 ? -1 : 0;
+        if(value < best && (value > 0 ? 1 : value < 0 ? -1 : 0) == sign) best = value;
+        board.unmakeMove(move, undo);
+        if(state == failed) return 0;
+    }
+    // no legal moves is checkmate
+    return best == 0xFFFF ? -1 : best;
+}
+
+// DTZ of a position whose best move is a capture or pawn move, from its WDL result
+int Tablebase::dtzBeforeZeroing(int wdl) {
+    return wdl == win ? 1 : wdl == cursedWin ? 101 : wdl == blessedLoss ? -101 : wdl == loss ? -1 : 0;
+}
+
+// one key per material combination, from the counts of each table piece kind, 4 bits each
+uint64_t Tablebase::materialKey(const int white [7], const int black [7]) {
+    uint64_t key = 0;
+    for(int kind = 1; kind <= 6; kind++) {
+        key |= uint64_t(white[kind]) << (4 * (kind - 1)) | uint64_t(black[kind]) << (4 * (kind + 5));
+    }
+    return key;
+}
+
+// rank minus file: 0 on the a1-h8 diagonal, negative below it
+inline int Tablebase::offDiagonal(int sq) {
+    return sq / 8 - sq % 8;
+}
+
+inline int Tablebase::leftSymbol(const Pairs &pairs, int symbol) {
+    const uint8_t *pair = pairs.symbolPairs + 3 * symbol;
+    return (pair[1] & 0xF) << 8 | pair[0];
+}
+
+inline int Tablebase::rightSymbol(const Pairs &pairs, int symbol) {
+    const uint8_t *pair = pairs.symbolPairs + 3 * symbol;
+    return pair[2] << 4 | pair[1] >> 4;
+}
+
+inline uint32_t Tablebase::little16(const uint8_t *bytes) {
+    return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8;
+}
+
+inline uint32_t Tablebase::little32(const uint8_t *bytes) {
+    return little16(bytes) | little16(bytes + 2) << 16;
+}
+
+inline uint64_t Tablebase::big(const uint8_t *bytes, int length) {
+    uint64_t value = 0;
+    for(int i = 0; i < length; i++) value = value << 8 | bytes[i];
+    return value;
+}
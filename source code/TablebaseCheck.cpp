@@ -0,0 +1,370 @@
+#pragma once
+#include "Tablebase.cpp"
+#include <cctype>
+#include <iostream>
+#include <random>
+
+//
+// Tablebase prober check. The three piece endings with a queen, a rook or a pawn are solved here by brute force, every
+// position of them is probed and both results compared, with the colors swapped too. Larger endings are too big for
+// that, so random positions of them are probed and checked against the probes of every move from them: the WDL result
+// must be the best of the results after the moves, and the DTZ value one more than the best DTZ after a move.
+//
+// The solver needs no tables. It is checked on its own against the longest wins of KQvK and KRvK, mate in 10 and 16.
+//
+
+class TablebaseCheck {
+public:
+    static bool checkSolver();
+    static bool run(const std::string &paths);
+
+private:
+    // a solved ending of white king, one white piece and black king, by index
+    struct Solution {
+        std::vector<int8_t> wdl; // loss, draw or win for the side to move, illegal if the position can't occur
+        std::vector<int16_t> dtz; // plies to the next capture, pawn move or mate. 0 if checkmated or drawn
+    };
+    // a move in a solved ending. capture and promotions leave it, to is -1 and wdl is the result after them
+    struct Edge {
+        int to;
+        bool zeroing;
+        int8_t wdl;
+    };
+
+    const static int8_t illegal = 3;
+    const static int positions = 64 * 64 * 64 * 2;
+    const static int samples = 2000; // random positions of each larger ending
+    const static char *const larger [];
+
+    static const Solution &solution(int piece);
+    static Solution solve(int piece);
+    static int index(const BoardState &board, int piece);
+    static std::string fen(const char squares [64], bool whiteTurn);
+    static bool placeOf(int i, int piece, char squares [64], bool &whiteTurn);
+    static bool compare(const char *name, int piece);
+    static bool checkMoves(const char *name);
+    static bool randomPosition(const char *name, std::mt19937_64 &random, BoardState &board);
+    static int sign(int value);
+};
+
+// four and five piece endings checked move by move, with the strong side first
+const char *const TablebaseCheck::larger [] = {"KRvKP", "KQvKR", "KRPvKR", "KQPvKQ"};
+
+// the longest wins of KQvK and KRvK, from the known mate in 10 and mate in 16. returns true if the solver finds them
+bool TablebaseCheck::checkSolver() {
+    struct Longest {
+        int piece;
+        const char *name;
+        int plies; // white to move
+    };
+    const Longest endings [] = {{4, "KQvK", 19}, {1, "KRvK", 31}};
+    bool passed = true;
+    for(const Longest &ending : endings) {
+        const Solution &solved = solution(ending.piece);
+        int found = 0;
+        for(int i = 0; i < positions; i += 2) {
+            if(solved.wdl[i] == Tablebase::win) found = std::max<int>(found, solved.dtz[i]);
+        }
+        bool ok = found == ending.plies;
+        passed = passed && ok;
+        std::cout << ending.name << " longest win " << found << " plies, expected " << ending.plies
+        << (ok ? "" : "  FAILED") << "\n";
+    }
+    return passed;
+}
+
+// maps the tables in paths and checks the prober with them. returns true if every probe matched
+bool TablebaseCheck::run(const std::string &paths) {
+    int found = Tablebase::init(paths);
+    std::cout << found << " tables found, up to " << Tablebase::maxPieces() << " pieces\n";
+    bool passed = true;
+    passed = compare("KQvK", 4) && passed;
+    passed = compare("KRvK", 1) && passed;
+    passed = compare("KPvK", 6) && passed;
+    for(const char *name : larger) passed = checkMoves(name) && passed;
+    Tablebase::clear();
+    return passed;
+}
+
+// solved endings are kept, KPvK needs the other two for its promotions
+const TablebaseCheck::Solution &TablebaseCheck::solution(int piece) {
+    static Solution solved [7];
+    if(solved[piece].wdl.empty()) solved[piece] = solve(piece);
+    return solved[piece];
+}
+
+// solves an ending by working back from the checkmates. the results come first, with every move followed through the
+// ending until nothing changes, then the DTZ values one ply at a time: a win in n plies has a move to a loss in n - 1
+// or a capture or pawn move that wins, and a loss in n has only moves to wins, the longest in n - 1
+TablebaseCheck::Solution TablebaseCheck::solve(int piece) {
+    const Solution *queen = piece == 6 ? &solution(4) : nullptr;
+    const Solution *rook = piece == 6 ? &solution(1) : nullptr;
+    Solution solved;
+    solved.wdl.assign(positions, illegal);
+    solved.dtz.assign(positions, 0);
+    std::vector<int> first(positions + 1, 0); // edges of position i are first[i] up to first[i + 1]
+    std::vector<Edge> edges;
+    const int8_t unknown = 1;
+
+    for(int i = 0; i < positions; i++) {
+        first[i] = int(edges.size());
+        char squares [64];
+        bool whiteTurn;
+        if(!placeOf(i, piece, squares, whiteTurn)) continue;
+        BoardState board = BoardState::fromFEN(fen(squares, whiteTurn));
+        if(board.inCheck(!whiteTurn)) continue;
+
+        MoveList moves;
+        board.generateMoves(moves);
+        for(Move move : moves) {
+            bool zeroing = board.isCapture(move) || board.pieceAt(move.from()) == 6;
+            Undo undo = board.makeMove(move);
+            Edge edge{-1, zeroing, Tablebase::draw};
+            if(board.pieceCount() == 2) {
+                // the piece was taken, kings alone draw
+            } else if(board.pieceBoard(true, piece)) {
+                edge.to = index(board, piece);
+            } else if(board.pieceBoard(true, 4)) {
+                edge.wdl = queen->wdl[index(board, 4)];
+            } else if(board.pieceBoard(true, 1)) {
+                edge.wdl = rook->wdl[index(board, 1)];
+            }
+            edges.push_back(edge);
+            board.unmakeMove(move, undo);
+        }
+        solved.wdl[i] = moves.empty() ? (board.inCheck(whiteTurn) ? Tablebase::loss : Tablebase::draw) : unknown;
+    }
+    first[positions] = int(edges.size());
+
+    auto after = [&](const Edge &edge) { return edge.to == -1 ? edge.wdl : solved.wdl[edge.to]; };
+    for(bool changed = true; changed;) {
+        changed = false;
+        for(int i = 0; i < positions; i++) {
+            if(solved.wdl[i] != unknown) continue;
+            bool wins = false, loses = true;
+            for(int e = first[i]; e < first[i + 1]; e++) {
+                wins = wins || after(edges[e]) == Tablebase::loss;
+                loses = loses && after(edges[e]) == Tablebase::win;
+            }
+            if(wins || loses) {
+                solved.wdl[i] = wins ? Tablebase::win : Tablebase::loss;
+                changed = true;
+            }
+        }
+    }
+    for(int8_t &wdl : solved.wdl) {
+        if(wdl == unknown) wdl = Tablebase::draw;
+    }
+
+    // solved[i].dtz stays 0 until it is found, which checkmates are
+    std::vector<bool> done(positions);
+    int remaining = 0;
+    for(int i = 0; i < positions; i++) {
+        bool decided = solved.wdl[i] == Tablebase::win || solved.wdl[i] == Tablebase::loss;
+        done[i] = !decided || first[i] == first[i + 1];
+        if(!done[i]) remaining++;
+    }
+    // every win and loss is found long before the cap, it only guards against a bug looping forever
+    for(int plies = 1; remaining > 0 && plies < 1000; plies++) {
+        std::vector<int> found;
+        for(int i = 0; i < positions; i++) {
+            if(done[i]) continue;
+            bool win = solved.wdl[i] == Tablebase::win, reached = !win;
+            for(int e = first[i]; e < first[i + 1]; e++) {
+                const Edge &edge = edges[e];
+                if(win) {
+                    if(edge.zeroing ? after(edge) == Tablebase::loss && plies == 1
+                                    : after(edge) == Tablebase::loss && done[edge.to]
+                                      && solved.dtz[edge.to] == plies - 1) reached = true;
+                } else if(!edge.zeroing && (!done[edge.to] || solved.dtz[edge.to] > plies - 1)) {
+                    reached = false;
+                }
+            }
+            if(reached) found.push_back(i);
+        }
+        for(int i : found) {
+            solved.dtz[i] = int16_t(plies);
+            done[i] = true;
+        }
+        remaining -= int(found.size());
+    }
+    return solved;
+}
+
+// index of a position of white king, white piece and black king
+int TablebaseCheck::index(const BoardState &board, int piece) {
+    int whiteKing = lsb(board.pieceBoard(true, 5)), blackKing = lsb(board.pieceBoard(false, 5));
+    int square = lsb(board.pieceBoard(true, piece));
+    return ((whiteKing * 64 + blackKing) * 64 + square) * 2 + (board.isWhiteTurn() ? 0 : 1);
+}
+
+// the squares and side to move of an index, as FEN letters. returns false if the pieces can't stand there
+bool TablebaseCheck::placeOf(int i, int piece, char squares [64], bool &whiteTurn) {
+    whiteTurn = i % 2 == 0;
+    int square = i / 2 % 64, blackKing = i / 128 % 64, whiteKing = i / 8192;
+    if(square == whiteKing || square == blackKing || whiteKing == blackKing) return false;
+    if(piece == 6 && (square < 8 || square >= 56)) return false;
+    std::fill(squares, squares + 64, ' ');
+    squares[whiteKing] = 'K';
+    squares[blackKing] = 'k';
+    squares[square] = " RNBQKP"[piece];
+    return true;
+}
+
+// FEN of the pieces on squares, with no castling rights, en passant square or moves played
+std::string TablebaseCheck::fen(const char squares [64], bool whiteTurn) {
+    std::string text;
+    for(int y = 7; y >= 0; y--) {
+        int empty = 0;
+        for(int x = 0; x < 8; x++) {
+            char piece = squares[x + 8 * y];
+            if(piece == ' ') {
+                empty++;
+                continue;
+            }
+            if(empty > 0) text += char('0' + empty);
+            empty = 0;
+            text += piece;
+        }
+        if(empty > 0) text += char('0' + empty);
+        if(y > 0) text += '/';
+    }
+    return text + (whiteTurn ? " w - - 0 1" : " b - - 0 1");
+}
+
+// probes every position of a three piece ending and its mirror with the colors swapped, and compares them with the
+// solution. a DTZ table may store one more ply than the exact value, which isn't counted against it
+bool TablebaseCheck::compare(const char *name, int piece) {
+    const Solution &solved = solution(piece);
+    int checked = 0, wrongWdl = 0, wrongDtz = 0, missing = 0;
+    for(int i = 0; i < positions; i++) {
+        if(solved.wdl[i] == illegal) continue;
+        char squares [64], mirrored [64];
+        bool whiteTurn;
+        placeOf(i, piece, squares, whiteTurn);
+        for(int sq = 0; sq < 64; sq++) {
+            char letter = squares[sq ^ 56];
+            mirrored[sq] = char(std::isupper(letter) ? std::tolower(letter) : std::toupper(letter));
+        }
+
+        for(const std::string &text : {fen(squares, whiteTurn), fen(mirrored, !whiteTurn)}) {
+            BoardState board = BoardState::fromFEN(text);
+            int wdl, dtz;
+            if(!Tablebase::probeWdl(board, wdl) || !Tablebase::probeDtz(board, dtz)) {
+                missing++;
+                continue;
+            }
+            checked++;
+            bool wdlOk = wdl == solved.wdl[i];
+            // checkmated positions have no DTZ to compare
+            int exact = solved.wdl[i] == Tablebase::loss ? -solved.dtz[i] : solved.dtz[i];
+            bool dtzOk = solved.dtz[i] == 0 && solved.wdl[i] == Tablebase::loss ? dtz < 0
+                       : sign(dtz) == sign(exact) && (exact - dtz == 0 || exact - dtz == sign(exact));
+            if(!wdlOk && wrongWdl++ < 5) {
+                std::cout << "  " << text << " wdl " << wdl << ", expected " << int(solved.wdl[i]) << "\n";
+            }
+            if(!dtzOk && wrongDtz++ < 5) std::cout << "  " << text << " dtz " << dtz << ", expected " << exact << "\n";
+        }
+    }
+
+    bool passed = missing == 0 && wrongWdl == 0 && wrongDtz == 0;
+    std::cout << name << ": " << checked << " probes, " << wrongWdl << " wrong wdl, " << wrongDtz << " wrong dtz"
+    << (missing > 0 ? ", table missing" : "") << (passed ? "" : "  FAILED") << "\n";
+    return passed;
+}
+
+// probes random positions of an ending and every move from them. the WDL result, with the fifty move rule left out,
+// must be the best result after a move, and the DTZ value within a ply of the best DTZ after a move: a capture or pawn
+// move that wins counts as 1 (101 if the fifty move rule saves the loser), any other move one more than the DTZ
+// after it
+bool TablebaseCheck::checkMoves(const char *name) {
+    std::mt19937_64 random(12345);
+    int checked = 0, wrongWdl = 0, wrongDtz = 0;
+    for(int n = 0; n < samples; n++) {
+        BoardState board;
+        if(!randomPosition(name, random, board)) break;
+        int wdl, dtz;
+        if(!Tablebase::probeWdl(board, wdl) || !Tablebase::probeDtz(board, dtz)) {
+            std::cout << name << ": table missing, skipped\n";
+            return true;
+        }
+        checked++;
+
+        MoveList moves;
+        board.generateMoves(moves);
+        int bestWdl = moves.empty() ? (board.inCheck(board.isWhiteTurn()) ? -1 : 0) : -1;
+        int bestDtz = wdl > 0 ? INT_MAX : 0;
+        bool failed = false;
+        for(Move move : moves) {
+            bool zeroing = board.isCapture(move) || board.pieceAt(move.from()) == 6;
+            Undo undo = board.makeMove(move);
+            int wdlAfter = 0, dtzAfter = 0;
+            if(!Tablebase::probeWdl(board, wdlAfter) || !Tablebase::probeDtz(board, dtzAfter)) {
+                failed = true;
+                board.unmakeMove(move, undo);
+                continue;
+            }
+            bestWdl = std::max(bestWdl, -sign(wdlAfter));
+            int value = zeroing ? -wdlAfter : -dtzAfter;
+            if(zeroing) {
+                value = value == Tablebase::win ? 1 : value == Tablebase::cursedWin ? 101
+                      : value == Tablebase::blessedLoss ? -101 : value == Tablebase::loss ? -1 : 0;
+            } else if(board.checkmate()) {
+                value = 1;
+            } else {
+                value += sign(value);
+            }
+            if(wdl > 0 && value > 0) bestDtz = std::min(bestDtz, value);
+            if(wdl < 0) bestDtz = std::min(bestDtz, value);
+            board.unmakeMove(move, undo);
+        }
+        if(failed) {
+            std::cout << name << ": a table after a capture is missing, skipped\n";
+            return true;
+        }
+
+        bool wdlOk = sign(wdl) == bestWdl && sign(dtz) == sign(wdl) && (std::abs(wdl) == 1) == (std::abs(dtz) > 100);
+        bool dtzOk = wdl == 0 || moves.empty() || std::abs(bestDtz - dtz) <= 1;
+        if(!wdlOk && wrongWdl++ < 5) {
+            std::cout << "  " << board.toFEN() << " wdl " << wdl << " dtz " << dtz << ", best after a move "
+            << bestWdl << "\n";
+        }
+        if(!dtzOk && wrongDtz++ < 5) {
+            std::cout << "  " << board.toFEN() << " dtz " << dtz << ", best after a move " << bestDtz << "\n";
+        }
+    }
+
+    bool passed = wrongWdl == 0 && wrongDtz == 0;
+    std::cout << name << ": " << checked << " positions, " << wrongWdl << " wrong wdl, " << wrongDtz
+    << " wrong dtz" << (passed ? "" : "  FAILED") << "\n";
+    return passed;
+}
+
+// places the pieces of an ending like KRvKP on random squares, white first, with pawns off the first and last rank
+// and a random side to move that doesn't leave the other king in check
+bool TablebaseCheck::randomPosition(const char *name, std::mt19937_64 &random, BoardState &board) {
+    for(int tries = 0; tries < 1000; tries++) {
+        char squares [64];
+        std::fill(squares, squares + 64, ' ');
+        bool white = true;
+        for(const char *letter = name; *letter; letter++) {
+            if(*letter == 'v') {
+                white = false;
+                continue;
+            }
+            int sq;
+            do {
+                sq = int(random() % 64);
+            } while(squares[sq] != ' ' || (*letter == 'P' && (sq < 8 || sq >= 56)));
+            squares[sq] = white ? *letter : char(std::tolower(*letter));
+        }
+        bool whiteTurn = random() % 2 == 0;
+        board = BoardState::fromFEN(fen(squares, whiteTurn));
+        if(!board.inCheck(!whiteTurn)) return true;
+    }
+    return false;
+}
+
+inline int TablebaseCheck::sign(int value) {
+    return value > 0 ? 1 : value < 0 ? -1 : 0;
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include "Score.cpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <new>
+
+//
+// Fixed size table of searched positions indexed by Zobrist hash, shared by all search threads without locks. Slots
+// are grouped into buckets the size of a cache line, so a probe only ever touches one line of memory. When a bucket is
+// full the shallowest entry from the oldest search is replaced.
+//
+
+// how a stored score relates to the real score of the position
+enum Bound : uint8_t {
+    boundNone, // empty entry
+    boundUpper, // every move failed low, real score <= score
+    boundLower, // a move failed high, real score >= score
+    boundExact
+};
+
+struct TTEntry {
+    int16_t score; // counted from the node, see toTable
+    uint16_t move; // packed best move, 0 if none
+    int8_t depth;
+    uint8_t ageBound; // search generation in the upper 6 bits, bound in the lower 2
+
+    Bound bound() const;
+    uint8_t age() const;
+};
+
+Bound TTEntry::bound() const {
+    return Bound(ageBound & 3);
+}
+
+uint8_t TTEntry::age() const {
+    return ageBound >> 2;
+}
+
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t mb);
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable &operator = (const TranspositionTable &) = delete;
+    void resize(size_t mb);
+    void clear();
+    void newSearch();
+    bool probe(uint64_t hash, TTEntry &entry) const;
+    void store(uint64_t hash, int depth, Bound bound, Score score, Move move);
+
+private:
+    // an entry is stored next to its hash xor'd with it. if two threads write the same slot at once the halves come
+    // from different entries, the xor no longer gives back the hash, and the slot just reads as a miss
+    struct Slot {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+    static_assert(sizeof(TTEntry) <= 8, "an entry must pack into one 64 bit word");
+
+    const static int bucketSize = 4;
+    struct alignas(64) Bucket {
+        Slot slots [bucketSize];
+    };
+    static_assert(sizeof(Bucket) == 64, "bucket must fill exactly one cache line");
+
+    Bucket *buckets;
+    size_t mask; // bucket count - 1, the count is a power of two
+    uint8_t age;
+
+    Bucket &bucketOf(uint64_t hash) const;
+    static uint64_t toData(const TTEntry &entry);
+    static TTEntry fromData(uint64_t data);
+};
+
+// allocates a table using at most mb megabytes
+TranspositionTable::TranspositionTable(size_t mb) {
+    buckets = nullptr;
+    resize(mb);
+}
+
+TranspositionTable::~TranspositionTable() {
+    free(buckets);
+}
+
+// reallocates the table, dropping all entries. the bucket count is rounded down to a power of two
+void TranspositionTable::resize(size_t mb) {
+    size_t count = 1;
+    while(count * 2 * sizeof(Bucket) <= std::max<size_t>(mb, 1) << 20) count *= 2;
+
+    free(buckets);
+    buckets = static_cast<Bucket *>(aligned_alloc(sizeof(Bucket), count * sizeof(Bucket)));
+    if(buckets == nullptr) throw std::bad_alloc();
+    mask = count - 1;
+    clear();
+}
+
+// must not be called while a search is running
+void TranspositionTable::clear() {
+    memset(static_cast<void *>(buckets), 0, (mask + 1) * sizeof(Bucket));
+    age = 0;
+}
+
+// called once per search so entries from earlier searches are replaced first
+void TranspositionTable::newSearch() {
+    age = (age + 1) & 63;
+}
+
+TranspositionTable::Bucket &TranspositionTable::bucketOf(uint64_t hash) const {
+    return buckets[hash & mask];
+}
+
+uint64_t TranspositionTable::toData(const TTEntry &entry) {
+    uint64_t data = 0;
+    memcpy(&data, &entry, sizeof(entry));
+    return data;
+}
+
+TTEntry TranspositionTable::fromData(uint64_t data) {
+    TTEntry entry;
+    memcpy(&entry, &data, sizeof(entry));
+    return entry;
+}
+
+// copies the entry for the position into entry, returns false if the position isn't stored
+bool TranspositionTable::probe(uint64_t hash, TTEntry &entry) const {
+    for(const Slot &slot : bucketOf(hash).slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if((slot.check.load(std::memory_order_relaxed) ^ data) == hash && data != 0) {
+            entry = fromData(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+// saves a search result. an existing entry for the same position is overwritten unless it is deeper from this same
+// search, otherwise the least valuable entry in the bucket makes room
+void TranspositionTable::store(uint64_t hash, int depth, Bound bound, Score score, Move move) {
+    Bucket &bucket = bucketOf(hash);
+    Slot *target = nullptr;
+    TTEntry old{};
+
+    for(Slot &slot : bucket.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if((slot.check.load(std::memory_order_relaxed) ^ data) == hash && data != 0) {
+            old = fromData(data);
+            if(depth < old.depth && bound != boundExact && old.age() == age) return;
+            target = &slot;
+            break;
+        }
+    }
+    if(target == nullptr) {
+        int worst = INT32_MAX;
+        for(Slot &slot : bucket.slots) {
+            TTEntry e = fromData(slot.data.load(std::memory_order_relaxed));
+            // empty slots first, then shallow entries, with every search of age counting as lost depth
+            int value = e.bound() == boundNone ? INT32_MIN : e.depth - 4 * ((age - e.age()) & 63);
+            if(value < worst) {
+                worst = value;
+                target = &slot;
+            }
+        }
+    } else if(move.special() == -1) {
+        // keep the best move we already knew for this position
+        move = Move(old.move);
+    }
+
+    TTEntry entry;
+    entry.score = int16_t(score);
+    entry.move = move.special() == -1 ? 0 : move.pack();
+    entry.depth = int8_t(depth);
+    entry.ageBound = uint8_t(age << 2 | bound);
+
+    uint64_t data = toData(entry);
+    target->check.store(hash ^ data, std::memory_order_relaxed);
+    target->data.store(data, std::memory_order_relaxed);
+}
@@ -0,0 +1,299 @@
+#pragma once
+#include "Search.cpp"
+#include "Book.cpp"
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+
+//
+// Universal Chess Interface front end, so the engine can be driven by chess GUIs and tournament managers. Commands are
+// read from stdin on the calling thread while the search runs on a worker thread, which lets "stop" and "isready" be
+// answered in the middle of a search.
+//
+
+class Uci {
+public:
+    Uci();
+    ~Uci();
+    bool command(const std::string &line);
+    void loop();
+
+private:
+    BoardState position;
+    KeyHistory history; // positions before position, from the moves of the last position command
+    TranspositionTable table;
+    Search search;
+    Book book;
+    std::thread worker;
+    std::atomic<bool> searchDone{true};
+    std::atomic<bool> stopReceived{false};
+    std::mutex outputLock;
+
+    void send(const std::string &line);
+    void setPosition(std::istringstream &args);
+    void setOption(std::istringstream &args);
+    void go(std::istringstream &args);
+    void stopSearch();
+
+    const static int defaultHashMB = 16;
+    const static int maxHashMB = 65536;
+    const static int maxThreads = 256;
+    // time kept back for the GUI and the pipe when the engine manages its own clock
+    const static int moveOverheadMS = 30;
+    // without movestogo the remaining time is spread over this many moves
+    const static int defaultMovesToGo = 30;
+};
+
+const int Uci::maxHashMB;
+const int Uci::maxThreads;
+
+Uci::Uci() : table(defaultHashMB), search(table) {
+    search.setReporter([this](const SearchInfo &info) {
+        std::string pv;
+        for(const std::string &move : position.lineStrings(info.pv)) pv += " " + move;
+        auto ms = std::max<int64_t>(info.time.count(), 1);
+        std::string score = isMateScore(info.score) ? "mate " + std::to_string(mateMoves(info.score))
+                                                    : "cp " + std::to_string(info.score);
+        send("info depth " + std::to_string(info.depth) + " score " + score + " nodes "
+             + std::to_string(info.nodes) + " nps " + std::to_string(info.nodes * 1000 / ms) + " time "
+             + std::to_string(info.time.count()) + " pv" + pv);
+    });
+}
+
+Uci::~Uci() {
+    stopSearch();
+}
+
+// reads commands until "quit" or the end of input
+void Uci::loop() {
+    std::string line;
+    while(std::getline(std::cin, line)) {
+        if(!command(line)) break;
+    }
+    stopSearch();
+}
+
+// handles one line of input. returns false on "quit"
+bool Uci::command(const std::string &line) {
+    std::istringstream args(line);
+    std::string name;
+    args >> name;
+
+    if(name == "uci") {
+        send("id name Chess-Engine");
+        send("id author aaronbanse");
+        send("option name Hash type spin default " + std::to_string(defaultHashMB) + " min 1 max "
+             + std::to_string(maxHashMB));
+        send("option name Threads type spin default 1 min 1 max " + std::to_string(maxThreads));
+        send("option name EvalFile type string default <empty>");
+        send("option name BookFile type string default <empty>");
+        send("option name SyzygyPath type string default <empty>");
+        send("uciok");
+    } else if(name == "isready") {
+        send("readyok");
+    } else if(name == "ucinewgame") {
+        stopSearch();
+        table.clear();
+        search.clear();
+        position = BoardState();
+        history.clear();
+    } else if(name == "setoption") {
+        stopSearch();
+        setOption(args);
+    } else if(name == "position") {
+        stopSearch();
+        setPosition(args);
+    } else if(name == "go") {
+        stopSearch();
+        go(args);
+    } else if(name == "stop") {
+        stopSearch();
+    } else if(name == "quit") {
+        return false;
+    } else if(name == "d") {
+        send(position.display() + position.toFEN());
+    } else if(!name.empty()) {
+        send("info string unknown command " + name);
+    }
+    return true;
+}
+
+// writes one line to stdout. the search thread reports while the input thread answers commands, so lines are locked
+void Uci::send(const std::string &line) {
+    std::lock_guard<std::mutex> lock(outputLock);
+    std::cout << line << std::endl;
+}
+
+// position [startpos | fen <fen>] [moves <move> ...]
+void Uci::setPosition(std::istringstream &args) {
+    std::string token;
+    args >> token;
+    BoardState board;
+    KeyHistory keys;
+    if(token == "fen") {
+        std::string fen;
+        while(args >> token && token != "moves") fen += token + " ";
+        try {
+            board = BoardState::fromFEN(fen);
+        } catch(const std::invalid_argument &e) {
+            send(std::string("info string ") + e.what());
+            return;
+        }
+    } else if(token == "startpos") {
+        args >> token;
+    } else {
+        send("info string position needs startpos or fen");
+        return;
+    }
+
+    if(token == "moves") {
+        while(args >> token) {
+            Move move = board.moveFromString(token);
+            if(move.special() == -1) {
+                send("info string illegal move " + token);
+                break;
+            }
+            keys.push(board.getHash());
+            board.makeMove(move);
+        }
+    }
+    position = board;
+    history = keys;
+}
+
+// setoption name <Hash | Threads> value <n>
+// setoption name EvalFile value <path>, loads a network for eval. an empty path goes back to the heuristic eval
+// setoption name BookFile value <path>, maps a Polyglot opening book. an empty path plays without a book
+// setoption name SyzygyPath value <directories>, maps the Syzygy tablebases found there. separated by ':'
+void Uci::setOption(std::istringstream &args) {
+    std::string token, name, value;
+    args >> token >> name >> token >> value;
+    // paths may contain spaces
+    std::string rest;
+    std::getline(args, rest);
+    value += rest;
+    bool empty = value.empty() || value == "<empty>";
+    try {
+        if(name == "BookFile") {
+            if(empty) {
+                book.close();
+                return;
+            }
+            try {
+                book.open(value);
+                send("info string loaded " + value);
+            } catch(const std::runtime_error &e) {
+                send(std::string("info string ") + e.what());
+            }
+        } else if(name == "SyzygyPath") {
+            if(empty) {
+                Tablebase::clear();
+            } else {
+                int found = Tablebase::init(value);
+                send("info string found " + std::to_string(found) + " tablebases, up to "
+                     + std::to_string(Tablebase::maxPieces()) + " pieces");
+            }
+        } else if(name == "EvalFile") {
+            if(empty) {
+                Network::unload();
+            } else {
+                try {
+                    Network::load(value);
+                    send("info string loaded network " + value);
+                } catch(const std::runtime_error &e) {
+                    send(std::string("info string ") + e.what());
+                }
+            }
+        } else if(name == "Hash") {
+            table.resize(std::min(std::max(std::stoi(value), 1), maxHashMB));
+        } else if(name == "Threads") {
+            search.setThreads(std::min(std::stoi(value), maxThreads));
+        } else {
+            send("info string unknown option " + name);
+        }
+    } catch(const std::exception &) {
+        send("info string bad value for option " + name);
+    }
+}
+
+// go [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>] [movetime <ms>] [depth <n>] [infinite]
+// starts the search on the worker thread, which prints bestmove when it is done. a book move is played at once unless
+// the search is infinite. other tokens are skipped with their values, searchmoves with its whole move list, so the
+// limits after them still count
+void Uci::go(std::istringstream &args) {
+    int64_t time [2] = {-1, -1};
+    int64_t increment [2] = {0, 0};
+    int64_t moveTime = -1;
+    int movesToGo = defaultMovesToGo;
+    int depth = Search::maxSearchDepth;
+    bool infinite = false;
+
+    const std::string valued [] = {"wtime", "btime", "winc", "binc", "movestogo", "movetime", "depth", "nodes", "mate"};
+    auto takesValue = [&valued](const std::string &token) {
+        return std::find(std::begin(valued), std::end(valued), token) != std::end(valued);
+    };
+    std::string token;
+    while(args >> token) {
+        if(token == "infinite") {
+            infinite = true;
+            continue;
+        }
+        // ponder, searchmoves and its moves, and anything unknown take no value
+        if(!takesValue(token)) continue;
+        int64_t value;
+        if(!(args >> value)) {
+            args.clear();
+            continue;
+        }
+        if(token == "wtime") time[0] = value;
+        else if(token == "btime") time[1] = value;
+        else if(token == "winc") increment[0] = value;
+        else if(token == "binc") increment[1] = value;
+        else if(token == "movestogo") movesToGo = int(std::max<int64_t>(value, 1));
+        else if(token == "movetime") moveTime = value;
+        else if(token == "depth") depth = int(std::min<int64_t>(std::max<int64_t>(value, 1), Search::maxSearchDepth));
+    }
+
+    // with no limit given the search runs until stop
+    int side = position.isWhiteTurn() ? 0 : 1;
+    std::chrono::milliseconds budget = std::chrono::hours(24 * 365);
+    if(moveTime >= 0) {
+        budget = std::chrono::milliseconds(std::max<int64_t>(moveTime - moveOverheadMS, 1));
+    } else if(time[side] >= 0 && !infinite) {
+        int64_t share = time[side] / movesToGo + increment[side] * 3 / 4;
+        share = std::min(share, time[side] - moveOverheadMS);
+        budget = std::chrono::milliseconds(std::max<int64_t>(share, 1));
+    }
+
+    if(!infinite) {
+        Move move = book.probe(position);
+        if(move.special() != -1) {
+            send("info string book move");
+            send("bestmove " + position.moveString(move));
+            return;
+        }
+    }
+
+    searchDone = false;
+    stopReceived = false;
+    worker = std::thread([this, budget, depth, infinite]() {
+        Move best = search.bestMove(position, history, budget, depth);
+        send("info string " + search.stats().summary());
+        // an infinite search may only answer once it has been told to stop
+        while(infinite && !stopReceived) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        send("bestmove " + position.moveString(best));
+        searchDone = true;
+    });
+}
+
+// stops the running search, if any, and waits for its bestmove
+void Uci::stopSearch() {
+    if(!worker.joinable()) return;
+    stopReceived = true;
+    // keep asking until the search is over. a stop that lands before the worker has started its search would be lost
+    while(!searchDone) {
+        search.stop();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    worker.join();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+//
+// Random keys for Zobrist hashing. The hash of a position is the xor of the keys of everything in it, so a move only
+// has to xor out what it takes away and xor in what it adds.
+//
+
+class Zobrist {
+public:
+    Zobrist();
+    uint64_t piece [12][64]; // same piece order as BoardState::pieces
+    uint64_t castle [4]; // same order as BoardState::canCastle
+    uint64_t enPassant [8]; // by file of the en passant square
+    uint64_t blackTurn;
+
+private:
+    uint64_t seed;
+    uint64_t next();
+};
+
+// fills every key from a fixed seed so hashes are the same on every run
+Zobrist::Zobrist() {
+    seed = 0x9E3779B97F4A7C15ULL;
+    for(auto &keys : piece) {
+        for(uint64_t &key : keys) key = next();
+    }
+    for(uint64_t &key : castle) key = next();
+    for(uint64_t &key : enPassant) key = next();
+    blackTurn = next();
+}
+
+// splitmix64 generator
+uint64_t Zobrist::next() {
+    uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+const Zobrist zobrist;
@@ -0,0 +1,17 @@
+#include "source code/TablebaseCheck.cpp"
+#include <cstdlib>
+#include <string>
+
+int main(int argc, char *argv[]) {
+    // "tbcheck [dirs]" checks the Syzygy prober against the tables in dirs, separated by ':', or in SYZYGY_PATH when
+    // none are given. without either only the brute force solver it compares with is checked
+    bool passed = TablebaseCheck::checkSolver();
+    const char *paths = argc > 1 ? argv[1] : std::getenv("SYZYGY_PATH");
+    if(paths == nullptr || *paths == '\0') {
+        std::cout << "SYZYGY_PATH not set, tables not checked\n";
+    } else {
+        passed = TablebaseCheck::run(paths) && passed;
+    }
+    std::cout << (passed ? "all checks passed" : "some checks FAILED") << "\n";
+    return passed ? 0 : 1;
+}